@@ -9,8 +9,15 @@
 
 #include "GLWidget.h"
 #include "MainWindow.h"
+#include <vector>
 
 #define INIT_DEPTH 3
+#define NAIL_DIAM  .04016
+#define NAIL_LEN   .75
+
+// attribute locations used by the nail instancing shader
+#define ATTR_VERTEX 0
+#define ATTR_OFFSET 1
 
 using namespace IP;
 
@@ -21,6 +28,18 @@ using namespace IP;
 //
 GLWidget::GLWidget(QWidget *parent)
 	: QGLWidget(parent),
+	m_boardList(0),
+	m_nailList(0),
+	m_nailsList(0),
+	m_instanced(false),
+	m_nailProgram(0),
+	m_meshBuffer(0),
+	m_instanceBuffer(0),
+	m_meshVertices(0),
+	m_instances(0),
+	m_glDrawArraysInstanced(0),
+	m_glVertexAttribDivisor(0),
+	m_sceneVersion(-1),
 	m_mousePosition(0, 0)
 {
 	// init variables
@@ -40,9 +59,13 @@ GLWidget::GLWidget(QWidget *parent)
 //
 GLWidget::~GLWidget()
 {
+	makeCurrent();
 	glDeleteLists(m_boardList, 1);
 	glDeleteLists(m_nailList, 1);
 	glDeleteLists(m_nailsList, 1);
+	if(m_meshBuffer)     glDeleteBuffers(1, &m_meshBuffer);
+	if(m_instanceBuffer) glDeleteBuffers(1, &m_instanceBuffer);
+	delete m_nailProgram;
 }
 
 
@@ -57,9 +80,11 @@ GLWidget::~GLWidget()
 void
 GLWidget::initializeGL()
 {
+	initializeOpenGLFunctions();
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LEQUAL);
 	glClearColor(.9, .9, .9, 1.0);
+	initInstancing();
 	initDisplayLists(1);
 }
 
@@ -101,9 +126,13 @@ GLWidget::paintGL()
 	// bring orthographic projection of camera position to the origin 
 	glTranslatef(-x, -y, 0);
 
-	// draw nails
-	initDisplayLists(1);
-	glCallList(m_nailsList);
+	// rebuild board and nails only if the scene changed since the last frame
+	if(m_sceneVersion != MainWindowP->sceneVersion())
+		initDisplayLists(0);
+
+	// draw board and nails
+	glCallList(m_boardList);
+	drawNails();
 }
 
 
@@ -228,46 +257,53 @@ GLWidget::mouseMoveEvent(QMouseEvent *event)
 //
 // Init display lists.
 //! \brief	Init display lists.
-//! \details	Init display lists.
+//! \details	Build the single nail list (first time only, flag=1) and
+//!		rebuild the board and nails from the current nail map,
+//!		spacing and art dimensions. Lists from a previous build are
+//!		deleted first. Records the scene version that was built.
 //
 void
 GLWidget::initDisplayLists(int flag)
 {
-	// create display list for board and single nail; only call it first time (flag=1)
+	// create display list for single nail; only call it first time (flag=1)
 	if (flag) {
-		// draw board
-		m_boardList = glGenLists(1);
-		glNewList(m_boardList, GL_COMPILE);
+		if (m_nailList) glDeleteLists(m_nailList, 1);
+		m_nailList = glGenLists(1);
+		glNewList(m_nailList, GL_COMPILE);
+		drawCylinder((NAIL_DIAM / 2), NAIL_LEN);
+		glEndList();
+	}
 
-		ImagePtr I;
-		double spacing, artWidth, artHeight, ar;
+	double spacing, artWidth, artHeight, ar;
 
-		//get nail spacing , and art dimension values
-		MainWindowP->getParams(I, spacing, artWidth, artHeight);
+	//get nail spacing , and art dimension values
+	MainWindowP->getParams(spacing, artWidth, artHeight);
+	m_sceneVersion = MainWindowP->sceneVersion();
 
-		// compute aspect ratio
-		ar = artWidth / artHeight;
+	// compute aspect ratio
+	ar = artWidth / artHeight;
 
-		if(artWidth > artHeight)
-			drawBoard(2, 2/ar, .05);
-		else	
-			drawBoard(2*ar, 2, .05);
+	// draw board
+	if (m_boardList) glDeleteLists(m_boardList, 1);
+	m_boardList = glGenLists(1);
+	glNewList(m_boardList, GL_COMPILE);
+	if(artWidth > artHeight)
+		drawBoard(2, 2/ar, .05);
+	else	
+		drawBoard(2*ar, 2, .05);
+	glEndList();
 
-		glEndList();
-		
-		// draw single nail
-		m_nailList = glGenLists(1);
-		glNewList(m_nailList, GL_COMPILE);
-		drawCylinder((.04016 / 2), .75);
+	// upload nail positions for the instanced path; otherwise
+	// create display list for the nails
+	if(m_instanced) {
+		initNailInstances();
+	} else {
+		if (m_nailsList) glDeleteLists(m_nailsList, 1);
+		m_nailsList = glGenLists(1);
+		glNewList(m_nailsList, GL_COMPILE);
+		drawNailsImmediate();
 		glEndList();
 	}
-
-	// create display list for the nails
-	m_nailsList = glGenLists(1);
-	glNewList(m_nailsList, GL_COMPILE);
-	glCallList(m_boardList);
-	drawNails();
-	glEndList();
 }
 
 
@@ -384,62 +420,138 @@ GLWidget::drawCylinder(float r, float h)
 
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// GLWidget::drawNails:
+// GLWidget::setNailTransform:
 //
-// Draw 3D nails.
-//! \brief	Draw 3D board.
-//! \details	Draw 3D board.
+// Map art coordinates (inches, origin at the top left nail) onto the board.
+//! \brief	Map art coordinates onto the board.
+//! \details	Translate to the top left nail and scale art dimensions
+//!		to board coordinates.
 //
 void
-GLWidget::drawNails()
+GLWidget::setNailTransform()
 {
-
-	ImagePtr I;
 	double spacing, artWidth, artHeight;
 
 	// get nail spacing, and art dimension values
-	MainWindowP->getParams(I, spacing, artWidth, artHeight);
-	double dx = spacing;
-	double dy = dx;
+	MainWindowP->getParams(spacing, artWidth, artHeight);
 	double s1;
 	double s2;
 	double ar = artWidth / artHeight;
-	
-	glPushMatrix();
 
 	// compute board side lengths based on aspect ratio and translate gl matrix appropriately (credit: Muhammad)
 	if (artWidth > artHeight)
 	{
 		s1 = 2 / artWidth;
 		s2 = (2/ar) / artHeight;
-		glTranslatef(-1 + (.04016 / 4), (1 / ar) - (.04016 / 4), 0);
+		glTranslatef(-1 + (NAIL_DIAM / 4), (1 / ar) - (NAIL_DIAM / 4), 0);
 	}
 	else
 	{
 		s1 = (2*ar) / artWidth;
 		s2 = 2/ artHeight;
-		glTranslatef(-ar + (.04016 / 4), 1 - (.04016 / 4), 0);
+		glTranslatef(-ar + (NAIL_DIAM / 4), 1 - (NAIL_DIAM / 4), 0);
 	}
 
 	// compute scale factor that relates art dimensions and board coordinates
 	double s = MIN(s1, s2);
 	glScalef(s, s, s);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GLWidget::drawNails:
+//
+// Draw 3D nails.
+//! \brief	Draw 3D nails.
+//! \details	Draw all nails with one instanced draw call of the shared
+//!		nail mesh, or with the nails display list if instancing
+//!		is not supported by the GL implementation.
+//
+void
+GLWidget::drawNails()
+{
+	glPushMatrix();
+	setNailTransform();
+
+	if(!m_instanced) {
+		glCallList(m_nailsList);
+		glPopMatrix();
+		return;
+	}
+
+	if(m_instances) {
+		// set the color to black
+		glColor3f(0.0, 0.0, 0.0);
+
+		m_nailProgram->bind();
+
+		// per-vertex nail mesh
+		glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffer);
+		glEnableVertexAttribArray(ATTR_VERTEX);
+		glVertexAttribPointer(ATTR_VERTEX, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+		// per-instance nail position
+		glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		glEnableVertexAttribArray(ATTR_OFFSET);
+		glVertexAttribPointer(ATTR_OFFSET, 2, GL_FLOAT, GL_FALSE, 0, 0);
+		m_glVertexAttribDivisor(ATTR_OFFSET, 1);
+
+		m_glDrawArraysInstanced(GL_TRIANGLES, 0, m_meshVertices, m_instances);
+
+		m_glVertexAttribDivisor(ATTR_OFFSET, 0);
+		glDisableVertexAttribArray(ATTR_OFFSET);
+		glDisableVertexAttribArray(ATTR_VERTEX);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_nailProgram->release();
+	}
+	glPopMatrix();
+}
+
+
 
-	// draw array of scaled cylinders
-	int type;
-	IP::ChannelPtr<uchar> p1;
-	IP::IP_getChannel(I, 0, p1, type);
-	int w = I->width();
-	int h = I->height();
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GLWidget::drawNailsImmediate:
+//
+// Draw 3D nails one at a time.
+//! \brief	Draw 3D nails one at a time.
+//! \details	Fallback for GL implementations without instancing:
+//!		call the single nail display list at every set bit of
+//!		the nail map.
+//
+void
+GLWidget::drawNailsImmediate()
+{
+	double spacing, artWidth, artHeight;
+
+	// get nail spacing, and art dimension values
+	MainWindowP->getParams(spacing, artWidth, artHeight);
+	const IP::BitChannel &map = MainWindowP->nailMap();
+	if(map.isNull()) return;
+	double dx = spacing;
+	double dy = dx;
+
+	// draw array of scaled cylinders; rows without nails are skipped
+	const std::vector<int> &rows = MainWindowP->rowNails();
+	int h = map.height();
+	glPushMatrix();
 	for (int y = 0; y<h; y++) {
-		glPushMatrix();
+		if (y < (int) rows.size() && !rows[y]) {
+			glTranslatef(0., -dy, 0.);
+			continue;
+		}
 
-		// draw cylinders only where black pixels are found in row
-		for (int x = 0; x<w; x++, p1++) {
-			if (!*p1) glCallList(m_nailList);
-			glTranslatef(dx, 0., 0.);
+		// draw cylinders only where nail bits are set in row
+		const IP::BitWord *p1 = map.row(y);
+		for (int i = 0; i<map.words(); i++) {
+			for (IP::BitWord bits = p1[i]; bits; bits &= bits-1) {
+				int x = 64*i + IP::BitChannel::lowestBit(bits);
+				glPushMatrix();
+				glTranslatef(x * dx, 0., 0.);
+				glCallList(m_nailList);
+				glPopMatrix();
+			}
 		}
-		glPopMatrix();
 		glTranslatef(0., -dy, 0.);
 	}
 	glPopMatrix();
@@ -447,6 +559,155 @@ GLWidget::drawNails()
 
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GLWidget::initInstancing:
+//
+// Set up instanced nail rendering.
+//! \brief	Set up instanced nail rendering.
+//! \details	Resolve the instancing entry points (GL 3.3 or
+//!		ARB_instanced_arrays), compile the nail shader and upload
+//!		the shared nail mesh. Leaves m_instanced false if any
+//!		step fails, so that drawNails() falls back to display lists.
+//
+void
+GLWidget::initInstancing()
+{
+	QOpenGLContext *ctx = QOpenGLContext::currentContext();
+	m_glDrawArraysInstanced = (DrawArraysInstancedFn)
+		ctx->getProcAddress("glDrawArraysInstanced");
+	if(!m_glDrawArraysInstanced)
+		m_glDrawArraysInstanced = (DrawArraysInstancedFn)
+			ctx->getProcAddress("glDrawArraysInstancedARB");
+	m_glVertexAttribDivisor = (VertexAttribDivisorFn)
+		ctx->getProcAddress("glVertexAttribDivisor");
+	if(!m_glVertexAttribDivisor)
+		m_glVertexAttribDivisor = (VertexAttribDivisorFn)
+			ctx->getProcAddress("glVertexAttribDivisorARB");
+	if(!m_glDrawArraysInstanced || !m_glVertexAttribDivisor)
+		return;
+
+	// offset each nail mesh by its instance position before the
+	// fixed-function modelview and projection transformations
+	static const char *vshader =
+		"#version 120\n"
+		"attribute vec3 a_vertex;\n"
+		"attribute vec2 a_offset;\n"
+		"void main() {\n"
+		"	gl_FrontColor = gl_Color;\n"
+		"	gl_Position = gl_ModelViewProjectionMatrix *\n"
+		"		vec4(a_vertex.xy + a_offset, a_vertex.z, 1.0);\n"
+		"}\n";
+	static const char *fshader =
+		"#version 120\n"
+		"void main() {\n"
+		"	gl_FragColor = gl_Color;\n"
+		"}\n";
+
+	m_nailProgram = new QOpenGLShaderProgram;
+	m_nailProgram->addShaderFromSourceCode(QOpenGLShader::Vertex,   vshader);
+	m_nailProgram->addShaderFromSourceCode(QOpenGLShader::Fragment, fshader);
+	m_nailProgram->bindAttributeLocation("a_vertex", ATTR_VERTEX);
+	m_nailProgram->bindAttributeLocation("a_offset", ATTR_OFFSET);
+	if(!m_nailProgram->link()) {
+		delete m_nailProgram;
+		m_nailProgram = 0;
+		return;
+	}
+
+	glGenBuffers(1, &m_meshBuffer);
+	glGenBuffers(1, &m_instanceBuffer);
+	initNailMesh((NAIL_DIAM / 2), NAIL_LEN);
+	m_instanced = true;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GLWidget::initNailMesh:
+//
+// Upload triangle mesh of a single nail.
+//! \brief	Upload triangle mesh of a single nail.
+//! \details	Same cylinder as drawCylinder(), as a triangle list.
+//! \param[in]	r - cylinder radius
+//! \param[in]	h - cylinder height
+//
+void
+GLWidget::initNailMesh(float r, float h)
+{
+	float degToRad = M_PI / 180.;
+	std::vector<GLfloat> v;
+
+	for (int i = 0; i < 360; i += 5) {
+		float a0 = i * degToRad;	// convert to radians
+		float a1 = (i + 5) * degToRad;
+		float x0 = r*cos(a0), y0 = r*sin(a0);
+		float x1 = r*cos(a1), y1 = r*sin(a1);
+		GLfloat tri[] = {
+			// cylinder top at z = h (front)
+			0,  0,  h,   x0, y0, h,   x1, y1, h,
+			// cylinder bottom at z = 0 (rear)
+			0,  0,  0,   x1, y1, 0,   x0, y0, 0,
+			// cylinder sides
+			x0, y0, h,   x0, y0, 0,   x1, y1, 0,
+			x0, y0, h,   x1, y1, 0,   x1, y1, h
+		};
+		v.insert(v.end(), tri, tri + sizeof(tri) / sizeof(GLfloat));
+	}
+	m_meshVertices = v.size() / 3;
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_meshBuffer);
+	glBufferData(GL_ARRAY_BUFFER, v.size() * sizeof(GLfloat), &v[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// GLWidget::initNailInstances:
+//
+// Upload the position of every nail.
+//! \brief	Upload the position of every nail.
+//! \details	Walk the packed nail map once and store the art
+//!		coordinates of every nail in the instance buffer.
+//
+void
+GLWidget::initNailInstances()
+{
+	double spacing, artWidth, artHeight;
+
+	// get nail spacing, and art dimension values
+	MainWindowP->getParams(spacing, artWidth, artHeight);
+	const IP::BitChannel &map = MainWindowP->nailMap();
+	m_instances = 0;
+	if(map.isNull()) return;
+
+	// collect (x,y) offsets of set bits; the nail counts from the dither
+	// stage size the buffer up front and let empty rows be skipped, and
+	// empty 64-pixel runs are skipped a word at a time
+	const std::vector<int> &rows = MainWindowP->rowNails();
+	std::vector<GLfloat> pos;
+	pos.reserve(2 * MainWindowP->nailCount());
+	for (int y = 0; y<map.height(); y++) {
+		if (y < (int) rows.size() && !rows[y]) continue;
+		const IP::BitWord *p1 = map.row(y);
+		for (int i = 0; i<map.words(); i++) {
+			for (IP::BitWord bits = p1[i]; bits; bits &= bits-1) {
+				int x = 64*i + IP::BitChannel::lowestBit(bits);
+				pos.push_back( x * spacing);
+				pos.push_back(-y * spacing);
+			}
+		}
+	}
+	m_instances = pos.size() / 2;
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, pos.size() * sizeof(GLfloat),
+		     pos.empty() ? 0 : &pos[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // GLWidget::reset:
 //
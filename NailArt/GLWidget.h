@@ -18,6 +18,7 @@
 #include <GL/glu.h>
 #include <QtOpenGL>
 #include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
 #include "IP.h"
 
 
@@ -28,7 +29,7 @@
 ///
 //////////////////////////////////////////////////////////////////////////
 
-class GLWidget : public QGLWidget {
+class GLWidget : public QGLWidget, protected QOpenGLFunctions {
 	Q_OBJECT
 
 public:
@@ -54,8 +55,16 @@ protected:
 	void		drawBoard(float, float, float);
 	void		drawCylinder(float, float);
 	void		drawNails();
+	void		drawNailsImmediate();
+	void		setNailTransform();
+	void		initInstancing();
+	void		initNailMesh(float, float);
+	void		initNailInstances();
 
 private:
+	typedef void (QOPENGLF_APIENTRYP DrawArraysInstancedFn)(GLenum, GLint, GLsizei, GLsizei);
+	typedef void (QOPENGLF_APIENTRYP VertexAttribDivisorFn)(GLuint, GLuint);
+
 	int			m_windowW;
 	int			m_windowH;
 	float		m_xmax;
@@ -63,6 +72,15 @@ private:
 	GLuint		m_boardList;
 	GLuint		m_nailList;
 	GLuint		m_nailsList;
+	bool		m_instanced;		// instanced nail rendering available
+	QOpenGLShaderProgram *m_nailProgram;	// shader that offsets nail instances
+	GLuint		m_meshBuffer;		// VBO: triangles of a single nail
+	GLuint		m_instanceBuffer;	// VBO: (x,y) offset of every nail
+	int		m_meshVertices;
+	int		m_instances;
+	DrawArraysInstancedFn	m_glDrawArraysInstanced;
+	VertexAttribDivisorFn	m_glVertexAttribDivisor;
+	int		m_sceneVersion;		// MainWindow scene version of current lists
 	QPoint		m_mousePosition;
 	bool		m_orthoView;
 	float		m_rotation[3];
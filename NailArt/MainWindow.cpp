@@ -24,13 +24,20 @@ int	DefaultDisplay  = 1;
 // MainWindow constructor.
 //
 MainWindow::MainWindow(QWidget *parent)
-	:  QWidget(parent)
+	:  QWidget(parent),
+	   m_nails(0),
+	   m_sceneVersion(0)
 {
 	setWindowTitle("Nail Art");
 
 	// init global var
 	MainWindowP = this;	// main window pointer
 
+	// start background preview thread
+	m_worker = new PreviewWorker(this);
+	connect(m_worker, SIGNAL(resultReady()), this, SLOT(previewReady()));
+	m_worker->start();
+
 	// add control panel groupboxes to vertical box layout 
 	QVBoxLayout *vbox = new QVBoxLayout;
 	vbox->addWidget(createGroupInput  ());
@@ -162,7 +169,7 @@ MainWindow::createGroupDimensions()
 	// set member variables
 	m_artWidth = m_valueBox[0]->value();
 	m_artHeight = m_valueBox[1]->value();
-	m_spacing = .15748;
+	m_spacing = Pipeline::gaugeSpacing(18);
 
 	// assemble widgets into layout
 	layout->addWidget(m_valueBox[0], 0, 1);
@@ -298,6 +305,12 @@ MainWindow::createGroupFilter()
 		layout->addWidget(m_spinBox[i], i, 2);
 	}
 
+	// serpentine dither scans (the library's) are serial; raster scans
+	// run on all cores but place nails differently
+	m_checkRaster = new QCheckBox("Raster scan (faster dither)");
+	m_checkRaster->setChecked(false);
+	layout->addWidget(m_checkRaster, NUMSLIDERS, 0, 1, 3);
+
 	// create filter widget and set its layout
 	QWidget *widget = new QWidget;
 	widget->setLayout(layout);
@@ -318,6 +331,7 @@ MainWindow::createGroupFilter()
 	connect(m_spinBox[3], SIGNAL(valueChanged(double)), this, SLOT(changeFilterSizeD(double)));
 	connect(m_slider[4], SIGNAL(valueChanged(int)), this, SLOT(changeFilterFctrI(int)));
 	connect(m_spinBox[4], SIGNAL(valueChanged(double)), this, SLOT(changeFilterFctrD(double)));
+	connect(m_checkRaster, SIGNAL(stateChanged(int)), this, SLOT(changeScan(int)));
 
 
 	return groupBox;
@@ -432,6 +446,7 @@ MainWindow::load()
 	// read input image and convert to grayscale
 	m_imageSrc = IP::IP_readImage(qPrintable(m_file));
 	IP_castImage(m_imageSrc, BW_IMAGE, m_imageSrc);
+	m_worker->setSource(m_imageSrc);
 
 	// compute aspect ratio
 	m_ar = (double) m_imageSrc->width() / m_imageSrc->height();
@@ -441,6 +456,7 @@ MainWindow::load()
 
 	m_artWidth = 16.;
 	m_artHeight = 16. / m_ar;
+	m_sceneVersion++;
 
 	m_valueBox[0]->setValue(m_artWidth);
 	m_valueBox[1]->setValue(m_artHeight);
@@ -460,12 +476,40 @@ MainWindow::load()
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // MainWindow::preview:
 //
-// Compute preview image.
+// Request preview image. The pipeline runs on the worker thread;
+// previewReady() is invoked when the result is available.
 //
 void
 MainWindow::preview()
 {
-	applyFilter(m_imageSrc, m_imageDst);
+	// error checking
+	if(m_imageSrc.isNull()) return;		// no input image
+
+	// collect parameters and hand them to the worker
+	PipelineParams params;
+	getFilterParams(params);
+	m_worker->request(params);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MainWindow::previewReady:
+//
+// Slot to pick up the preview image computed by the worker thread.
+//
+void
+MainWindow::previewReady()
+{
+	if(!m_worker->takeResult(m_nailMap, m_rowNails, m_nails)) return;
+	m_sceneVersion++;
+
+	// set nails
+	m_imgLabel[1]->setText(QString("%1 nails").arg(m_nails));
+
+	// set size
+	QString artSize = QString("%1 x %2 pixels").arg(m_nailMap.width()).arg(m_nailMap.height());
+	m_imgLabel[2]->setText(artSize);
 
 	// display requested image
 	int i;
@@ -482,59 +526,25 @@ MainWindow::preview()
 
 
 
-// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-// MainWindow::applyFilter:
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MainWindow::getFilterParams:
 //
-// Run filter on the image, transforming I1 to I2.
-// Overrides ImageFilterDialog::applyFilter().
-// Return 1 for success, 0 for failure.
+// Collect filter parameters from the control panel.
 //
-bool
-MainWindow::applyFilter(ImagePtr I1, ImagePtr I2)
+void
+MainWindow::getFilterParams(PipelineParams &params)
 {
-	// error checking
-	if(I1.isNull()) {
-		IP_printfErr("applyFilter: Missing image");
-		return 0;	// failure
-	}
-
-	// collect parameters
-	double brightness = m_slider[0]->value();
-	double contrast = m_slider[1]->value();
-	double gamma = m_slider[2]->value() / 10.;
-	double filterSize = m_slider[3]->value();
-	double filterFctr = m_slider[4]->value();
-
-	int histo[256];
-	double hmin, hmax;
-
-	// convert contrast range from [-100, 100] range to [0, 5] range
-	if (contrast >= 0)
-		contrast = contrast / 25. + 1.;
-	else
-		contrast = 1 + (contrast / 133.);
-
-	// compute width and height
-	int w = m_artWidth / m_spacing;
-	int h = m_artHeight / m_spacing;
-
-	// apply filter
-	IP_resize(I1, w, h, IP::TRIANGLE, I2);
-	IP_contrast(I2, brightness, contrast, 128, I2);
-	IP_sharpen(I2, filterSize, filterSize, filterFctr, I2);
-	IP_ditherDiffuse(I2, IP::JARVIS_JUDICE_NINKE, gamma, I2);
-	IP_copyImage(I2, m_imageDst);
-
-	// set nails
-	IP_histogram(I2, 0, histo, 256, hmin, hmax);
-	QString nails = QString("%1 nails").arg(histo[0]);
-	m_imgLabel[1]->setText(nails);
-
-	// set size
-	QString artSize = QString("%1 x %2 pixels").arg(I2->width()).arg(I2->height());
-	m_imgLabel[2]->setText(artSize);
-
-	return 1;	// success
+	params.artWidth   = m_artWidth;
+	params.artHeight  = m_artHeight;
+	params.spacing    = m_spacing;
+	params.brightness = m_slider[0]->value();
+	params.contrast   = m_slider[1]->value();
+	params.gamma      = m_slider[2]->value() / 10.;
+	params.filterSize = m_slider[3]->value();
+	params.filterFctr = m_slider[4]->value();
+	params.engine     = IP::DIFFUSE_EXACT;
+	params.scan       = m_checkRaster->isChecked() ? IP::DIFFUSE_RASTER
+						       : IP::DIFFUSE_SERPENTINE;
 }
 
 
@@ -551,31 +561,32 @@ void MainWindow::display(int flag)
 {
 	// error checking
 	if(m_imageSrc.isNull()) return;		// no input image
-	if(m_imageDst.isNull())			// compute output image
-		applyFilter(m_imageSrc, m_imageDst);
+	if(flag && m_nailMap.isNull()) {	// output image not ready yet
+		preview();
+		return;
+	}
 
 	// raise the appropriate widget from the stack
 	m_stackWidget->setCurrentIndex(flag);
 
-	// determine image to be displayed
-	ImagePtr I;
+	// convert image to be displayed to QImage; the nail map is
+	// expanded straight from its packed bits
+	QImage q;
 	int w, h;
 	if (flag == 0)
 	{
-		I = m_imageSrc;
+		IP_IPtoQImage(m_imageSrc, q);
 		w = m_stackWidget->width();
 		h = m_stackWidget->height();
 	}
 	else 
 	{
-		I = m_imageDst;
-		w = m_imageDst->width();
-		h = m_imageDst->height();
+		IP_bitsToQImage(m_nailMap, q);
+		w = m_nailMap.width();
+		h = m_nailMap.height();
 	}
 
-	// convert from ImagePtr to QImage to Pixmap
-	QImage q;
-	IP_IPtoQImage(I, q);
+	// convert from QImage to Pixmap
 	QPixmap p = QPixmap::fromImage(q.scaled(QSize(w,h), Qt::KeepAspectRatio));
 
 	// assign pixmap to label widget for display
@@ -601,12 +612,11 @@ void MainWindow::displayGL(int flag)
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // MainWindow::getParams:
 //
-// Get image parameters.
+// Get nail spacing and art dimensions. The nail map is read with nailMap().
 //
 void
-MainWindow::getParams(ImagePtr &I, double &spacing, double &artWidth, double &artHeight)
+MainWindow::getParams(double &spacing, double &artWidth, double &artHeight)
 {
-	I = m_imageDst;
 	spacing = m_spacing;
 	artWidth = m_artWidth;
 	artHeight = m_artHeight;
@@ -27,6 +27,7 @@
 #include <algorithm>
 
 #include "GLWidget.h"
+#include "PreviewWorker.h"
 #include "IP.h"
 #include "IPtoUI.h"
 
@@ -41,9 +42,13 @@ class MainWindow : public QWidget {
 public:
 	// constructor
 	MainWindow	(QWidget *parent = 0);
-	void		getParams(ImagePtr&, double&, double&, double&);
+	void		getParams(double&, double&, double&);
+	const BitChannel &nailMap() const { return m_nailMap; }
+	int		nailCount() const { return m_nails; }
+	const std::vector<int> &rowNails() const { return m_rowNails; }
 	void		getArtWidth(double&);
 	void		getArtHeight(double&);
+	int		sceneVersion() const { return m_sceneVersion; }
 
 public slots:
 	int			load		();
@@ -60,6 +65,7 @@ public slots:
 	void		changeFilterSizeD(double);
 	void		changeFilterFctrI(int);
 	void		changeFilterFctrD(double);
+	void		changeScan(int);
 	void		changeGauge(int);
 	void		changeArtWidth(double);
 	void		changeArtHeight(double);
@@ -80,17 +86,24 @@ protected:
 protected slots:
 	void		save();
 	void		quit();
+	void		previewReady();
 
 private:
 	// image pointers
 	ImagePtr	 m_imageSrc;
-	ImagePtr	 m_imageDst;
+	BitChannel	 m_nailMap;	// dithered output: bit set where a nail goes
+	std::vector<int> m_rowNails;	// nails per row of m_nailMap
+	int		 m_nails;	// nails in m_nailMap
+
+	// background preview pipeline
+	PreviewWorker	*m_worker;
 
 	// image info
 	double m_spacing;
 	double m_artWidth;
 	double m_artHeight;
 	double m_ar; // aspect ratio
+	int    m_sceneVersion; // bumped when a nail map arrives or an image loads
 
 
 	// widgets for input groupbox
@@ -99,6 +112,7 @@ private:
 	// widgets for image filter groupbox
 	QSlider		*m_slider [NUMSLIDERS];
 	QDoubleSpinBox	*m_spinBox[NUMSLIDERS];
+	QCheckBox	*m_checkRaster;	// raster dither scan (parallel)
 
 	// widgets for physical dimensions groupbox
 	QDoubleSpinBox *m_valueBox[2];
@@ -118,8 +132,8 @@ private:
 	void	display	 (int);
 	void	displayGL(int);
 	void	preview  ();
+	void	getFilterParams(PipelineParams&);
 	void	messageBadSave(QString);
-	bool	applyFilter(ImagePtr, ImagePtr);
 };
 
 extern MainWindow *MainWindowP;
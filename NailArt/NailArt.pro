@@ -30,8 +30,14 @@ unix:!macx {
 
 # Input
 HEADERS += MainWindow.h \
-		   GLWidget.h
+		   GLWidget.h \
+		   Pipeline.h \
+		   StreamPipeline.h \
+		   PreviewWorker.h
 SOURCES += main.cpp \
            MainWindow.cpp \
 	   	   change.cpp \
-	   	   GLWidget.cpp
+	   	   GLWidget.cpp \
+	   	   Pipeline.cpp \
+	   	   StreamPipeline.cpp \
+	   	   PreviewWorker.cpp
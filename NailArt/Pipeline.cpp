@@ -0,0 +1,223 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// Pipeline.cpp - Pipeline class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include "Pipeline.h"
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::Pipeline:
+//
+// Pipeline constructor.
+//
+Pipeline::Pipeline()
+	: m_resizedW(0),
+	  m_resizedH(0),
+	  m_width  (0),
+	  m_height (0),
+	  m_threads(0),
+	  m_nails  (0)
+{
+	invalidate();
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::invalidate:
+//
+// Mark all cached stage outputs, the summed-area table and the cached
+// resize as stale. Call this when the source image is modified in place.
+//
+void
+Pipeline::invalidate()
+{
+	m_area.clear();
+	m_resizedW = m_resizedH = 0;
+	for(int i=0; i<NUMSTAGES; i++)
+		m_valid[i] = false;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::outputSize:
+//
+// Compute output width and height (in nails) from art size and spacing.
+//
+void
+Pipeline::outputSize(const PipelineParams &params, int &w, int &h)
+{
+	w = params.artWidth  / params.spacing;
+	h = params.artHeight / params.spacing;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::contrastFactor:
+//
+// Convert contrast from the [-100, 100] slider range to the [0, 5]
+// factor range used by IP_contrast().
+//
+double
+Pipeline::contrastFactor(double contrast)
+{
+	if (contrast >= 0)
+		return contrast / 25. + 1.;
+	return 1 + (contrast / 133.);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::setThreads:
+//
+// Set number of threads used by the sharpen and dither stages
+// (0: all cores).
+// Callers that already run several pipelines at once should pass 1.
+//
+void
+Pipeline::setThreads(int n)
+{
+	m_threads = n;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::gaugeSpacing:
+//
+// Return the nail spacing (inches) for a nail gauge (16, 18 or 23).
+// Return 0 for an unsupported gauge.
+//
+double
+Pipeline::gaugeSpacing(int gauge)
+{
+	switch(gauge) {
+	case 16: return .23622;		// thick
+	case 18: return .15748;		// medium
+	case 23: return .11811;		// thin
+	}
+	return 0;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::firstDirtyStage:
+//
+// Return the index of the first stage whose cached output was produced
+// with parameters other than params (or NUMSTAGES if all are current).
+//
+int
+Pipeline::firstDirtyStage(const PipelineParams &params, int w, int h) const
+{
+	if(!m_valid[TONE] || w != m_width || h != m_height ||
+	    params.brightness != m_params.brightness ||
+	    params.contrast   != m_params.contrast)
+		return TONE;
+	if(!m_valid[SHARPEN] ||
+	    params.filterSize != m_params.filterSize ||
+	    params.filterFctr != m_params.filterFctr)
+		return SHARPEN;
+	if(!m_valid[DITHER] || params.gamma != m_params.gamma ||
+	    params.engine != m_params.engine || params.scan != m_params.scan)
+		return DITHER;
+	return NUMSTAGES;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Pipeline::run:
+//
+// Run the pipeline on I1 with the given parameters, writing into I2.
+// Stages upstream of the first changed parameter are reused from cache.
+// If abort is given, it is polled before each stage and the run is
+// abandoned once it becomes nonzero.
+// Return 1 for success, 0 for failure or abandoned run.
+//
+bool
+Pipeline::run(const ImagePtr &I1, const PipelineParams &params,
+	      const ImagePtr &I2, const QAtomicInt *abort)
+{
+	// error checking
+	if(I1.isNull()) return 0;
+
+	// a new source image invalidates every stage
+	if(I1 != m_source) {
+		m_source = I1;
+		invalidate();
+	}
+
+	// compute width and height
+	int w, h;
+	outputSize(params, w, h);
+	if(w <= 0 || h <= 0) return 0;
+
+	// convert contrast range from [-100, 100] range to [0, 5] range
+	double contrast = contrastFactor(params.contrast);
+
+	// mark the first stale stage and every stage after it for recomputation
+	int first = firstDirtyStage(params, w, h);
+	for(int i=first; i<NUMSTAGES; i++)
+		m_valid[i] = false;
+
+	// remember parameters of cached stages
+	m_params = params;
+	m_width  = w;
+	m_height = h;
+
+	for(int i=first; i<NUMSTAGES; i++) {
+		if(abort && abort->load()) return 0;
+
+		switch(i) {
+		case TONE: {
+			// brightness/contrast lut, applied as pixels are resized
+			uchar lut[MXGRAY];
+			IP_toneLut(params.brightness, contrast, 128, lut);
+
+			// area averaging when shrinking; the table is built
+			// once per source image, and resize() declines sizes
+			// whose sums would overflow it
+			if(m_area.isNull()) m_area.build(m_source);
+			if(w <= m_area.width() && h <= m_area.height() &&
+			   m_area.resize(w, h, m_stage[TONE], lut))
+				break;
+
+			// filter when enlarging or declined; the filtered image
+			// is kept so that tone changes skip the resize
+			if(w != m_resizedW || h != m_resizedH) {
+				IP_resize(m_source, w, h, IP::TRIANGLE, m_resized);
+				m_resizedW = w;
+				m_resizedH = h;
+			}
+			IP_contrastFast(m_resized, params.brightness, contrast,
+					128, m_stage[TONE]);
+			break;
+		}
+		case SHARPEN:
+			IP_sharpenMT(m_stage[TONE], params.filterSize,
+				     params.filterSize, params.filterFctr,
+				     m_stage[SHARPEN], m_threads);
+			break;
+		case DITHER:
+			m_rowNails.resize(h);
+			m_nails = IP_ditherDiffuseMT(m_stage[SHARPEN],
+					   IP::JARVIS_JUDICE_NINKE, params.gamma,
+					   m_stage[DITHER], m_threads,
+					   params.engine, m_rowNails.data(),
+					   params.scan);
+			break;
+		}
+		m_valid[i] = true;
+	}
+
+	IP_copyImage(m_stage[DITHER], I2);
+	return 1;
+}
@@ -0,0 +1,101 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// Pipeline.h - Header file for Pipeline class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <vector>
+#include <QAtomicInt>
+#include "IP.h"
+
+using namespace IP;
+
+
+//////////////////////////////////////////////////////////////////////////
+///
+/// \struct PipelineParams
+/// \brief Filter parameters for one run of the nail art pipeline
+///
+/// Values are given in the same units as the MainWindow controls.
+///
+//////////////////////////////////////////////////////////////////////////
+
+struct PipelineParams {
+	double	artWidth;	// art width  (inches)
+	double	artHeight;	// art height (inches)
+	double	spacing;	// nail spacing (inches)
+	double	brightness;	// [-256, 256]
+	double	contrast;	// [-100, 100]
+	double	gamma;		// [0.1, 10]
+	double	filterSize;	// [1, 100]
+	double	filterFctr;	// [1, 100]
+	int	engine;		// dither engine (diffuse_engines)
+	int	scan;		// dither scan order (diffuse_scans)
+};
+
+
+
+//////////////////////////////////////////////////////////////////////////
+///
+/// \class Pipeline
+/// \brief Staged tone/sharpen/dither pipeline
+///
+/// The tone stage resizes the source and applies brightness/contrast
+/// through a lookup table in the same pass. The output of every stage
+/// is cached together with the parameters that produced it. A run
+/// recomputes only the first stage whose parameters changed and the
+/// stages downstream of it. A run may be abandoned between stages;
+/// stages finished so far stay cached. Minification uses a summed-area
+/// table of the source, built on the first run after the source
+/// changes, so that later resizes cost O(output pixels) regardless of
+/// source resolution. When enlarging, the filtered resize is cached on
+/// its own so that a tone change costs one lookup pass.
+/// The dither stage counts the nails (black pixels) of its output, in
+/// total and per row, so callers need no extra pass to count them.
+///
+//////////////////////////////////////////////////////////////////////////
+
+class Pipeline {
+public:
+	// constructor
+	Pipeline();
+
+	bool		run(const ImagePtr&, const PipelineParams&, const ImagePtr&,
+			    const QAtomicInt *abort = 0);
+	void		invalidate();
+	static void	outputSize(const PipelineParams&, int&, int&);
+	static double	contrastFactor(double);
+	void		setThreads(int);
+
+	static double	gaugeSpacing(int);
+
+	// nail counts of the last output, counted by the dither stage
+	int		nails() const { return m_nails; }
+	const std::vector<int> &rowNails() const { return m_rowNails; }
+
+private:
+	enum stages { TONE, SHARPEN, DITHER, NUMSTAGES };
+
+	int		firstDirtyStage(const PipelineParams&, int, int) const;
+
+	ImagePtr	m_source;		// source image of cached stages
+	AreaTable	m_area;			// summed-area table of m_source
+	ImagePtr	m_resized;		// filtered resize when enlarging
+	int		m_resizedW, m_resizedH;	// size of m_resized (0: stale)
+	ImagePtr	m_stage[NUMSTAGES];	// stage outputs
+	bool		m_valid[NUMSTAGES];	// stage output is up to date
+	PipelineParams	m_params;		// parameters of cached stages
+	int		m_width;		// output width  of cached stages
+	int		m_height;		// output height of cached stages
+	int		m_threads;		// sharpen/dither threads (0: all cores)
+	int		m_nails;		// black pixels in dither output
+	std::vector<int> m_rowNails;		// black pixels per output row
+};
+
+#endif // PIPELINE_H
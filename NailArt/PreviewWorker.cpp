@@ -0,0 +1,156 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// PreviewWorker.cpp - PreviewWorker class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <utility>
+#include "PreviewWorker.h"
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PreviewWorker::PreviewWorker:
+//
+// PreviewWorker constructor.
+//
+PreviewWorker::PreviewWorker(QObject *parent)
+	: QThread(parent),
+	  m_abort    (0),
+	  m_newSource(false),
+	  m_pending  (false),
+	  m_quit     (false),
+	  m_nails    (0)
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PreviewWorker::~PreviewWorker:
+//
+// PreviewWorker destructor. Abandon pending work and join the thread.
+//
+PreviewWorker::~PreviewWorker()
+{
+	m_mutex.lock();
+	m_quit = true;
+	m_abort.store(1);
+	m_cond.wakeOne();
+	m_mutex.unlock();
+	wait();
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PreviewWorker::setSource:
+//
+// Hand a private copy of source image I to the worker.
+// Called from the GUI thread.
+//
+void
+PreviewWorker::setSource(const ImagePtr &I)
+{
+	QMutexLocker locker(&m_mutex);
+
+	// previous source is released while the mutex is still held
+	ImagePtr copy;
+	IP_copyImage(I, copy);
+	m_source    = std::move(copy);
+	m_newSource = true;
+	m_abort.store(1);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PreviewWorker::request:
+//
+// Post a preview request, replacing any request that has not started.
+// Called from the GUI thread.
+//
+void
+PreviewWorker::request(const PipelineParams &params)
+{
+	QMutexLocker locker(&m_mutex);
+	m_params  = params;
+	m_pending = true;
+	m_abort.store(1);
+	m_cond.wakeOne();
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PreviewWorker::takeResult:
+//
+// Move the last finished nail map into map, its nail count per row into
+// rows and its total nail count into nails. Called from the GUI thread.
+// Return true if a result was available, false otherwise.
+//
+bool
+PreviewWorker::takeResult(BitChannel &map, std::vector<int> &rows, int &nails)
+{
+	QMutexLocker locker(&m_mutex);
+	if(m_result.isNull()) return false;
+
+	map.swap(m_result);
+	BitChannel().swap(m_result);
+	rows.swap(m_rowNails);
+	nails = m_nails;
+	return true;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// PreviewWorker::run:
+//
+// Thread loop: wait for the latest request and run the pipeline on it.
+//
+void
+PreviewWorker::run()
+{
+	for(;;) {
+		PipelineParams params;
+
+		// wait for work; take over the newest source and parameters
+		m_mutex.lock();
+		while(!m_pending && !m_quit)
+			m_cond.wait(&m_mutex);
+		if(m_quit) {
+			m_mutex.unlock();
+			return;
+		}
+		if(m_newSource) {
+			m_current   = std::move(m_source);
+			m_newSource = false;
+			m_pipeline.invalidate();
+		}
+		params    = m_params;
+		m_pending = false;
+		m_abort.store(0);
+		m_mutex.unlock();
+
+		// run pipeline; give up at a stage boundary if a newer request came in
+		ImagePtr out;
+		if(!m_pipeline.run(m_current, params, out, &m_abort))
+			continue;
+
+		// pack nails (black pixels) into a bit map; the dither stage
+		// has already counted them
+		BitChannel map;
+		IP_packBits(out, MXGRAY/2, map);
+		std::vector<int> rows = m_pipeline.rowNails();
+
+		// publish result; the previous one is freed after unlocking
+		m_mutex.lock();
+		m_result.swap(map);
+		m_rowNails.swap(rows);
+		m_nails = m_pipeline.nails();
+		m_mutex.unlock();
+
+		emit resultReady();
+	}
+}
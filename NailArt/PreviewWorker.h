@@ -0,0 +1,75 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// PreviewWorker.h - Header file for PreviewWorker class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#ifndef PREVIEWWORKER_H
+#define PREVIEWWORKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include "Pipeline.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+///
+/// \class PreviewWorker
+/// \brief Background thread that runs the preview pipeline
+///
+/// Requests posted from the GUI thread overwrite any request that has
+/// not started yet, so only the latest slider position is processed.
+/// A running request is abandoned at the next stage boundary when a
+/// newer one arrives. The worker owns a private copy of the source image
+/// and hands each result over under the mutex, so no image is ever
+/// referenced from both threads at once. Results are bit-packed nail
+/// maps (one bit per nail), 1/8 the size of the BW pipeline output.
+///
+//////////////////////////////////////////////////////////////////////////
+
+class PreviewWorker : public QThread {
+	Q_OBJECT
+
+public:
+	// constructor
+	PreviewWorker(QObject *parent = 0);
+
+	// destructor
+	~PreviewWorker();
+
+	void		setSource (const ImagePtr&);
+	void		request	  (const PipelineParams&);
+	bool		takeResult(BitChannel&, std::vector<int>&, int&);
+
+signals:
+	void		resultReady();
+
+protected:
+	void		run();
+
+private:
+	QMutex		m_mutex;
+	QWaitCondition	m_cond;
+	QAtomicInt	m_abort;	// set when the running request is stale
+
+	// shared state (guarded by m_mutex)
+	ImagePtr	m_source;	// pending source image
+	bool		m_newSource;	// m_source holds a new image
+	PipelineParams	m_params;	// pending parameters
+	bool		m_pending;	// m_params holds an unserved request
+	bool		m_quit;		// thread shutdown flag
+	BitChannel	m_result;	// last finished nail map (bit set: nail)
+	int		m_nails;	// number of nails in m_result
+	std::vector<int> m_rowNails;	// number of nails per row of m_result
+
+	// worker thread state
+	Pipeline	m_pipeline;
+	ImagePtr	m_current;	// source image used by m_pipeline
+};
+
+#endif // PREVIEWWORKER_H
@@ -0,0 +1,247 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// StreamPipeline.cpp - StreamPipeline class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include "StreamPipeline.h"
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// StreamPipeline::StreamPipeline:
+//
+// StreamPipeline constructor.
+//
+StreamPipeline::StreamPipeline()
+	: m_srcW (0), m_srcH (0),
+	  m_w	 (0), m_h    (0),
+	  m_hRing(0), m_hNext(0),
+	  m_ww	 (1), m_fctr (0),
+	  m_sRing(1), m_nails(0)
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// StreamPipeline::run:
+//
+// Run the pipeline on I1 with the given parameters, writing into I2.
+// I1 must have uchar channels (e.g., a BW_IMAGE); only channel 0 is used.
+// If abort is given, it is polled every few rows and the run is
+// abandoned once it becomes nonzero.
+// Return 1 for success, 0 for failure or abandoned run.
+//
+bool
+StreamPipeline::run(const ImagePtr &I1, const PipelineParams &params,
+		    const ImagePtr &I2, const QAtomicInt *abort)
+{
+	// error checking
+	if(I1.isNull()) return 0;
+	int type;
+	ChannelPtr<uchar> src;
+	IP_getChannel(I1, 0, src, type);
+	if(type != UCHAR_TYPE) {
+		IP_printfErr("StreamPipeline::run: uchar channel required");
+		return 0;
+	}
+
+	// compute width and height
+	m_srcW = I1->width();
+	m_srcH = I1->height();
+	Pipeline::outputSize(params, m_w, m_h);
+	if(m_w <= 0 || m_h <= 0) return 0;
+
+	// resize: area averaging when shrinking, as Pipeline does, else
+	// filter taps and ring of horizontally resized source rows
+	bool shrink = (m_w <= m_srcW && m_h <= m_srcH &&
+		       IP_areaFits(m_srcW, m_srcH, m_w, m_h));
+	AreaRows area(src.buf(), m_srcW, m_srcH, m_w, m_h);
+	if(!shrink) {
+		resizeTaps(m_srcW, m_w, m_xTaps, m_xWt);
+		resizeTaps(m_srcH, m_h, m_yTaps, m_yWt);
+		m_hRing = 1;
+		for(int y=0; y<m_h; y++)
+			m_hRing = MAX(m_hRing, m_yTaps[y].n);
+		m_hRows.assign((size_t) m_hRing * m_w, 0.f);
+		m_acc  .assign(m_w, 0.f);
+		m_hNext = 0;
+	}
+
+	// tone: brightness/contrast lut, applied as rows are resized
+	IP_toneLut(params.brightness, Pipeline::contrastFactor(params.contrast),
+		   128, m_toneLut);
+
+	// sharpen: filter sizes that IP_blurMT() filters; others leave
+	// the image as it is. Tone rows are blurred along the row here and
+	// down the columns by BlurRows, which hands back blurred rows up
+	// to about m_ww/2 rows late; keep the tone rows until then
+	m_ww   = params.filterSize;
+	m_fctr = params.filterFctr;
+	bool sharpen = (m_ww > 1 && m_ww < MXBLUR-1 &&
+			m_ww <= m_w && m_ww <= m_h);
+	m_sRing = sharpen ? (int) m_ww + 2 : 1;
+	m_cRows.assign((size_t) m_sRing * m_w, 0);
+	BlurRows blur(m_h, m_w, sharpen ? m_ww : 2.);
+
+	// dither: error rows only; nails are counted as rows are finished
+	DiffuseRows dither(IP_diffuseKernel(IP::JARVIS_JUDICE_NINKE), m_w,
+			   params.gamma, params.engine, params.scan);
+	m_nails = 0;
+	m_rowNails.assign(m_h, 0);
+
+	// output image is the only full-size buffer
+	IP_allocImageInI(I2, m_w, m_h, BW_TYPE);
+	ChannelPtr<uchar> dst;
+	IP_getChannel(I2, 0, dst, type);
+
+	// dither row y of the sharpened image
+	std::vector<uchar> hrow(m_w), brow(m_w), srow(m_w);
+	auto finish = [&](int y, const uchar *row) {
+		m_rowNails[y] = dither.next(row, dst.buf() + (size_t) y*m_w);
+		m_nails	     += m_rowNails[y];
+	};
+
+	// pull rows through the stages
+	for(int y=0; y<m_h; y++) {
+		if(abort && !(y % 16) && abort->load()) return 0;
+
+		uchar *trow = &m_cRows[(size_t) (y % m_sRing) * m_w];
+		if(shrink)
+			area.next(trow, m_toneLut);
+		else	resizeRow(y, src.buf(), trow);
+		if(!sharpen) {
+			finish(y, trow);
+			continue;
+		}
+
+		IP_blur1DScratch(ChannelPtr<uchar>(trow), m_w, 1, m_ww,
+				 ChannelPtr<uchar>(&hrow[0]));
+		int ys = blur.push(&hrow[0], &brow[0]);
+		if(ys >= 0) {
+			sharpenRow(ys, &brow[0], &srow[0]);
+			finish(ys, &srow[0]);
+		}
+	}
+	for(int ys; sharpen && (ys = blur.flush(&brow[0])) >= 0; ) {
+		sharpenRow(ys, &brow[0], &srow[0]);
+		finish(ys, &srow[0]);
+	}
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// StreamPipeline::resizeTaps:
+//
+// Compute triangle filter taps for resampling len input samples into
+// nlen output samples; used when an axis is enlarged. When minifying,
+// the filter is widened by the minification factor. Taps that fall off
+// the ends are dropped and the remaining weights renormalized.
+//
+void
+StreamPipeline::resizeTaps(int len, int nlen, std::vector<Taps> &taps,
+			   std::vector<float> &wts) const
+{
+	double scale   = (double) nlen / len;
+	double fscale  = MIN(scale, 1.);	// filter scale
+	double support = 1. / fscale;		// filter radius (input samples)
+
+	taps.resize(nlen);
+	wts.clear();
+	for(int u=0; u<nlen; u++) {
+		double center = (u + .5) / scale - .5;
+		int lo = MAX((int) ceil (center - support), 0);
+		int hi = MIN((int) floor(center + support), len-1);
+
+		Taps &tp = taps[u];
+		tp.wt	 = (int) wts.size();
+		tp.first = -1;
+		tp.n	 = 0;
+		double sum = 0;
+		for(int i=lo; i<=hi; i++) {
+			double w = 1. - fabs(i - center) * fscale;
+			if(w <= 0) {
+				if(tp.first < 0) continue;
+				break;
+			}
+			if(tp.first < 0) tp.first = i;
+			wts.push_back((float) w);
+			tp.n++;
+			sum += w;
+		}
+
+		// degenerate support: take nearest sample
+		if(!tp.n) {
+			tp.first = CLIP(ROUND(center), 0, len-1);
+			tp.n	 = 1;
+			wts.push_back(1.f);
+			sum = 1;
+		}
+		for(int i=0; i<tp.n; i++)
+			wts[tp.wt + i] /= (float) sum;
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// StreamPipeline::resizeRow:
+//
+// Compute resized row y into out, passing each pixel through the tone
+// lut as it is written. Source rows are resized horizontally once, when
+// first needed, into the m_hRows ring.
+//
+void
+StreamPipeline::resizeRow(int y, const uchar *src, uchar *out)
+{
+	const Taps &ty = m_yTaps[y];
+
+	// horizontally resize source rows up to the last one row y needs
+	for(; m_hNext < ty.first + ty.n; m_hNext++) {
+		const uchar *s = src + (size_t) m_hNext * m_srcW;
+		float	    *h = &m_hRows[(size_t) (m_hNext % m_hRing) * m_w];
+		for(int u=0; u<m_w; u++) {
+			const Taps  &tx = m_xTaps[u];
+			const float *wt = &m_xWt[tx.wt];
+			const uchar *p	= s + tx.first;
+			float sum = 0;
+			for(int i=0; i<tx.n; i++) sum += wt[i] * p[i];
+			h[u] = sum;
+		}
+	}
+
+	// vertical pass
+	for(int u=0; u<m_w; u++) m_acc[u] = 0;
+	for(int i=0; i<ty.n; i++) {
+		float	     wt = m_yWt[ty.wt + i];
+		const float *h	= &m_hRows[(size_t) ((ty.first+i) % m_hRing) * m_w];
+		for(int u=0; u<m_w; u++) m_acc[u] += wt * h[u];
+	}
+	for(int u=0; u<m_w; u++)
+		out[u] = m_toneLut[CLIP(ROUND(m_acc[u]), 0, MaxGray)];
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// StreamPipeline::sharpenRow:
+//
+// Compute sharpened row y into out from its box filtered version blur:
+// add m_fctr times the difference between the tone row and blur. The
+// steps round as in IP_sharpen(): the difference is scaled in double and
+// truncated to short, added to the tone row in short, and clipped to
+// uchar. Tone row y must still be in the m_cRows ring.
+//
+void
+StreamPipeline::sharpenRow(int y, const uchar *blur, uchar *out) const
+{
+	const uchar *in = &m_cRows[(size_t) (y % m_sRing) * m_w];
+	for(int x=0; x<m_w; x++) {
+		short d = (short) (int) (m_fctr * (in[x] - blur[x]));
+		short v = (short) (in[x] + d);
+		out[x]	= (uchar) CLIP(v, 0, MaxGray);
+	}
+}
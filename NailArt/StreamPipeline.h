@@ -0,0 +1,94 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// StreamPipeline.h - Header file for StreamPipeline class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#ifndef STREAMPIPELINE_H
+#define STREAMPIPELINE_H
+
+#include <vector>
+#include "Pipeline.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+///
+/// \class StreamPipeline
+/// \brief Row-streaming tone/sharpen/dither pipeline
+///
+/// Computes the same chain of stages as Pipeline, but pulls output rows
+/// through the stages one at a time. Each stage keeps only the rows it
+/// still needs in a small ring: resize keeps its vertical filter support,
+/// sharpen keeps filterSize rows, and dither keeps its error rows.
+/// Working memory is O(width x window) rather than a full image per
+/// stage, so large boards stay cache resident. Nothing is cached between
+/// runs; use Pipeline for interactive previews.
+///
+/// Shrinking averages source areas with the arithmetic of AreaTable
+/// (see AreaRows), sharpening blurs with IP_blur1DScratch() along rows
+/// and BlurRows down columns and rounds as IP_sharpen() does, and the
+/// dither engines are those of IP_ditherDiffuseMT(). A shrunk image thus
+/// gives the nail map of Pipeline, sharpened or not. Enlarging uses a
+/// triangle filter instead of IP_resize(), so enlarged maps are close to
+/// those of Pipeline but not identical: the dither carries the small
+/// differences on to the nails around them. nailart-test compares the
+/// two pipelines.
+///
+//////////////////////////////////////////////////////////////////////////
+
+class StreamPipeline {
+public:
+	// constructor
+	StreamPipeline();
+
+	bool		run(const ImagePtr&, const PipelineParams&, const ImagePtr&,
+			    const QAtomicInt *abort = 0);
+
+	// nail counts of the last output, counted by the dither stage
+	int		nails() const { return m_nails; }
+	const std::vector<int> &rowNails() const { return m_rowNails; }
+
+private:
+	// filter taps of one output sample: weights of src[first..first+n-1]
+	struct Taps {
+		int	first;		// first input sample
+		int	n;		// number of input samples
+		int	wt;		// index of first weight in m_*Wt
+	};
+
+	void		resizeTaps(int, int, std::vector<Taps>&,
+				   std::vector<float>&) const;
+	void		resizeRow (int, const uchar*, uchar*);
+	void		sharpenRow(int, const uchar*, uchar*) const;
+
+	// image dimensions
+	int		m_srcW, m_srcH;		// input  size
+	int		m_w,	m_h;		// output size (nails)
+
+	// resize: horizontal and vertical taps; ring of resized source rows
+	std::vector<Taps>  m_xTaps, m_yTaps;
+	std::vector<float> m_xWt,   m_yWt;
+	std::vector<float> m_hRows;		// ring of horizontally resized rows
+	std::vector<float> m_acc;		// vertical pass accumulator
+	int		m_hRing;		// rows in m_hRows
+	int		m_hNext;		// next source row to resize
+
+	// tone: brightness/contrast lut, applied as rows are resized
+	uchar		m_toneLut[MXGRAY];
+
+	// sharpen: box filter of width m_ww; ring of tone rows kept until
+	// their blurred rows come out of BlurRows
+	double		m_ww;			// box filter width
+	double		m_fctr;			// sharpen factor
+	int		m_sRing;		// rows in m_cRows
+	std::vector<uchar>  m_cRows;		// ring of tone rows
+
+	// dither: nail counts
+	int		m_nails;		// black pixels in output
+	std::vector<int> m_rowNails;		// black pixels per output row
+};
+
+#endif // STREAMPIPELINE_H
@@ -148,6 +148,18 @@ MainWindow::changeFilterFctrI(int val)
 	preview();
 }
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MainWindow::changeScan:
+//
+// Slot to process change in dither scan order caused by the checkbox.
+//
+void
+MainWindow::changeScan(int)
+{
+	// apply new values to stored image
+	preview();
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // MainWindow::changeGauge():
 //
@@ -160,15 +172,15 @@ MainWindow::changeGauge(int val)
 	{
 		case 0:
 			m_imgLabel[0]->setText(QString(".23622"));
-			m_spacing = .23622;
+			m_spacing = Pipeline::gaugeSpacing(16);
 			break;
 		case 1:
 			m_imgLabel[0]->setText(QString(".15748"));
-			m_spacing = .15748;
+			m_spacing = Pipeline::gaugeSpacing(18);
 			break;
 		case 2:
 			m_imgLabel[0]->setText(QString(".11811"));
-			m_spacing = .11811;
+			m_spacing = Pipeline::gaugeSpacing(23);
 			break;
 		default:
 			IP::IP_printfErr("MainWindow::changeGauge; Bad Index %d", val);
@@ -221,6 +233,7 @@ MainWindow::reset()
 	m_slider[2]->setValue(10);
 	m_slider[3]->setValue(3);
 	m_slider[4]->setValue(3);
+	m_checkRaster->setChecked(false);
 
 	// apply new values to stored image
 	preview();
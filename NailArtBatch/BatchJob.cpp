@@ -0,0 +1,137 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// BatchJob.cpp - BatchJob class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <cstdio>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include "BatchJob.h"
+
+// IP.lib is not known to be reentrant: it keeps globals (IP::Serpentine)
+// and non-atomic ImagePtr link counts. Only one job at a time may be
+// inside it; that job's pipeline uses all cores instead.
+static QMutex LibMutex;
+
+// keep report lines of concurrent jobs from interleaving
+static QMutex PrintMutex;
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BatchJob::BatchJob:
+//
+// BatchJob constructor. The job is owned by the caller.
+//
+BatchJob::BatchJob(const QString &in, const QString &out,
+		   const PipelineParams &params, bool stream)
+	: m_in    (in),
+	  m_out   (out),
+	  m_params(params),
+	  m_stream(stream),
+	  m_ok    (false),
+	  m_nails (0),
+	  m_width (0),
+	  m_height(0),
+	  m_msec  (0)
+{
+	setAutoDelete(false);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BatchJob::run:
+//
+// Process the job and report its nail count and wall time on stdout
+// (or the reason for failure on stderr). Called on a pool thread.
+//
+void
+BatchJob::run()
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QString msg;
+	m_ok   = process(msg);
+	m_msec = timer.elapsed();
+
+	PrintMutex.lock();
+	if(m_ok)
+		printf("%s: %d x %d, %d nails, %lld ms\n", qPrintable(m_in),
+		       m_width, m_height, m_nails, (long long) m_msec);
+	else
+		fprintf(stderr, "%s: %s\n", qPrintable(m_in), qPrintable(msg));
+	fflush(stdout);
+	PrintMutex.unlock();
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BatchJob::process:
+//
+// Read input image, run the pipeline, count nails and save the nail map.
+// Return 1 for success, 0 for failure (with the reason in msg).
+//
+bool
+BatchJob::process(QString &msg)
+{
+	// hold the library for the job's IP_* calls; saving the nail map
+	// needs only Qt and may overlap the next job
+	QMutexLocker locker(&LibMutex);
+
+	// read input image and convert to grayscale
+	ImagePtr I1 = IP_readImage(qPrintable(m_in));
+	if(I1.isNull()) {
+		msg = "cannot read image";
+		return 0;
+	}
+	IP_castImage(I1, BW_IMAGE, I1);
+
+	// derive missing art dimension from the aspect ratio of the image
+	double ar = (double) I1->width() / I1->height();
+	if(m_params.artWidth <= 0 && m_params.artHeight <= 0)
+		m_params.artWidth = 16.;
+	if(m_params.artWidth <= 0)
+		m_params.artWidth  = m_params.artHeight * ar;
+	if(m_params.artHeight <= 0)
+		m_params.artHeight = m_params.artWidth / ar;
+
+	// run pipeline on all cores; the dither stage counts the nails
+	ImagePtr I2;
+	bool ok;
+	if(m_stream) {
+		StreamPipeline pipeline;
+		ok = pipeline.run(I1, m_params, I2);
+		m_nails = pipeline.nails();
+	} else {
+		Pipeline pipeline;
+		ok = pipeline.run(I1, m_params, I2);
+		m_nails = pipeline.nails();
+	}
+	if(!ok) {
+		msg = "bad art size or nail spacing";
+		return 0;
+	}
+	m_width  = I2->width();
+	m_height = I2->height();
+
+	// pack nails (black pixels) into a bit map
+	BitChannel map;
+	IP_packBits(I2, MXGRAY/2, map);
+	I1 = I2 = ImagePtr();
+	locker.unlock();
+
+	// save 1-bit nail map; format is taken from the file suffix
+	QImage image;
+	IP_bitsToQImage(map, image);
+	if(!image.save(m_out)) {
+		msg = QString("cannot write %1").arg(m_out);
+		return 0;
+	}
+	return 1;
+}
@@ -0,0 +1,63 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// BatchJob.h - Header file for BatchJob class
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#ifndef BATCHJOB_H
+#define BATCHJOB_H
+
+#include <QRunnable>
+#include <QString>
+#include "Pipeline.h"
+#include "StreamPipeline.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+///
+/// \class BatchJob
+/// \brief One image of a nailart-batch run
+///
+/// Reads an image, runs it through its own Pipeline and saves the nail
+/// map. Jobs are run concurrently on a QThreadPool, but IP.lib is not
+/// known to be reentrant: a job holds a process-wide lock over its
+/// library calls and runs its pipeline on all cores, so jobs overlap
+/// only in saving their nail maps.
+/// An art width or height of 0 is derived from the other dimension and
+/// the aspect ratio of the image, as MainWindow::load() does.
+/// Streaming jobs use StreamPipeline, which keeps no full-size
+/// intermediate images.
+///
+//////////////////////////////////////////////////////////////////////////
+
+class BatchJob : public QRunnable {
+public:
+	// constructor
+	BatchJob(const QString &in, const QString &out, const PipelineParams&,
+		 bool stream = false);
+
+	void		run();
+
+	bool		ok     () const { return m_ok;    }
+	int		nails  () const { return m_nails; }
+	qint64		msec   () const { return m_msec;  }
+	const QString&	input  () const { return m_in;    }
+
+private:
+	bool		process(QString&);
+
+	QString		m_in;		// input image file
+	QString		m_out;		// output nail map file
+	PipelineParams	m_params;	// pipeline parameters
+	bool		m_stream;	// use StreamPipeline
+	bool		m_ok;		// job succeeded
+	int		m_nails;	// number of nails in output
+	int		m_width;	// output width  (nails)
+	int		m_height;	// output height (nails)
+	qint64		m_msec;		// wall time (milliseconds)
+};
+
+#endif // BATCHJOB_H
@@ -0,0 +1,295 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// main.cpp - main() function for nailart-batch.
+//
+// Usage: nailart-batch [options] input
+//
+// Run the nail art pipeline over every image of a directory, or over the
+// jobs listed in a manifest file. Each manifest line names one image,
+// followed by optional key=value overrides of the command-line defaults:
+//
+//	# image		overrides
+//	alice.jpg	width=24 gauge=23 contrast=20
+//	bob.png		height=18 gamma=1.4 output=bob_18in.png
+//
+// Keys: width, height (inches; 0 derives it from the aspect ratio, and
+// the width is 16 when both are 0), gauge (16, 18, 23), brightness,
+// contrast, gamma, size, factor (sharpen filter size and factor), engine
+// (exact: output of IP_ditherDiffuse, fixed: 16-bit fixed-point dither),
+// scan (serpentine: the library's dither scan, serial; raster: every row
+// left to right, dithered on all cores), output (nail map file).
+// Relative paths in a manifest are taken relative to the manifest.
+// With --stream, images are pushed through the stages a row at a time
+// without full-size intermediate images; use it for large boards. It
+// gives the nail maps of the default path, except that its enlarge step
+// filters differently, so enlarged maps are only close (see
+// StreamPipeline).
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <cstdio>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegExp>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVector>
+#include "BatchJob.h"
+
+// image files picked up from an input directory (same as MainWindow::load)
+static const char *ImageFilters[] = {
+	"*.jpg", "*.png", "*.ppm", "*.pgm", "*.bmp", 0
+};
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// setParam:
+//
+// Set parameter key of params (or the output file name) to value.
+// Return 1 for success, 0 for an unknown key or bad value.
+//
+static bool
+setParam(const QString &key, const QString &value, PipelineParams &params,
+	 QString &output)
+{
+	if(key == "output") {
+		output = value;
+		return 1;
+	}
+	if(key == "engine") {
+		if     (value == "exact") params.engine = DIFFUSE_EXACT;
+		else if(value == "fixed") params.engine = DIFFUSE_FIXED;
+		else	return 0;
+		return 1;
+	}
+	if(key == "scan") {
+		if     (value == "serpentine") params.scan = DIFFUSE_SERPENTINE;
+		else if(value == "raster"    ) params.scan = DIFFUSE_RASTER;
+		else	return 0;
+		return 1;
+	}
+
+	bool ok;
+	double v = value.toDouble(&ok);
+	if(!ok) return 0;
+
+	if     (key == "width"     ) params.artWidth   = v;
+	else if(key == "height"    ) params.artHeight  = v;
+	else if(key == "brightness") params.brightness = v;
+	else if(key == "contrast"  ) params.contrast   = v;
+	else if(key == "gamma"     ) params.gamma      = v;
+	else if(key == "size"      ) params.filterSize = v;
+	else if(key == "factor"    ) params.filterFctr = v;
+	else if(key == "gauge") {
+		params.spacing = Pipeline::gaugeSpacing((int) v);
+		if(params.spacing <= 0) return 0;
+	}
+	else	return 0;
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// outputFile:
+//
+// Return the nail map file for input image in: the given output name,
+// or <image basename>_nails.png, resolved against directory dir.
+//
+static QString
+outputFile(const QString &in, const QString &output, const QDir &dir)
+{
+	if(!output.isEmpty())
+		return dir.filePath(output);
+	return dir.filePath(QFileInfo(in).completeBaseName() + "_nails.png");
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// readManifest:
+//
+// Append one job per line of manifest file to jobs.
+// Return 1 for success, 0 for failure.
+//
+static bool
+readManifest(const QString &file, const PipelineParams &defaults,
+	     const QDir &outDir, bool stream, QVector<BatchJob*> &jobs)
+{
+	QFile f(file);
+	if(!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		fprintf(stderr, "nailart-batch: cannot open %s\n", qPrintable(file));
+		return 0;
+	}
+	QDir base = QFileInfo(file).absoluteDir();
+
+	QTextStream in(&f);
+	for(int line=1; !in.atEnd(); line++) {
+		QString text = in.readLine().section('#', 0, 0).trimmed();
+		if(text.isEmpty()) continue;
+
+		QStringList tokens = text.split(QRegExp("\\s+"));
+		PipelineParams params = defaults;
+		QString output;
+		for(int i=1; i<tokens.size(); i++) {
+			QString key   = tokens[i].section('=', 0, 0);
+			QString value = tokens[i].section('=', 1);
+			if(!setParam(key, value, params, output)) {
+				fprintf(stderr, "nailart-batch: %s:%d: bad parameter %s\n",
+					qPrintable(file), line, qPrintable(tokens[i]));
+				return 0;
+			}
+		}
+
+		QString image = base.filePath(tokens[0]);
+		jobs.append(new BatchJob(image, outputFile(image, output, outDir),
+					 params, stream));
+	}
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main:
+//
+// Parse command line, schedule one job per image on a thread pool
+// and wait for all of them. Exit status is the number of failed jobs
+// (capped at 255), or 255 for a usage error.
+//
+int main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("nailart-batch");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(
+		"Convert images into nail art maps without the GUI.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("input",
+		"Directory of images, or manifest file with one job per line.");
+
+	QCommandLineOption optOutput (QStringList() << "o" << "output",
+		"Write nail maps into <dir>.", "dir", ".");
+	QCommandLineOption optJobs   (QStringList() << "j" << "jobs",
+		"Run <n> jobs at once (default: number of cores).", "n");
+	QCommandLineOption optWidth     ("width",
+		"Art width in inches (0: from height and aspect ratio; "
+		"16 if both are 0).", "in", "0");
+	QCommandLineOption optHeight    ("height",
+		"Art height in inches (0: from width and aspect ratio).", "in", "0");
+	QCommandLineOption optGauge     ("gauge",
+		"Nail gauge: 16, 18 or 23.", "gauge", "18");
+	QCommandLineOption optBrightness("brightness",
+		"Brightness [-256, 256].", "v", "0");
+	QCommandLineOption optContrast  ("contrast",
+		"Contrast [-100, 100].", "v", "0");
+	QCommandLineOption optGamma     ("gamma",
+		"Dither gamma [0.1, 10].", "v", "1");
+	QCommandLineOption optSize      ("size",
+		"Sharpen filter size [1, 100].", "v", "3");
+	QCommandLineOption optFactor    ("factor",
+		"Sharpen factor [1, 100].", "v", "3");
+	QCommandLineOption optEngine    ("engine",
+		"Dither engine: exact or fixed.", "name", "exact");
+	QCommandLineOption optScan      ("scan",
+		"Dither scan: serpentine or raster (parallel).", "name",
+		"serpentine");
+	QCommandLineOption optStream    ("stream",
+		"Stream rows through the stages (low memory; enlarged nail "
+		"maps differ slightly from the default path).");
+	parser.addOption(optOutput);
+	parser.addOption(optJobs);
+	parser.addOption(optWidth);
+	parser.addOption(optHeight);
+	parser.addOption(optGauge);
+	parser.addOption(optBrightness);
+	parser.addOption(optContrast);
+	parser.addOption(optGamma);
+	parser.addOption(optSize);
+	parser.addOption(optFactor);
+	parser.addOption(optEngine);
+	parser.addOption(optScan);
+	parser.addOption(optStream);
+	parser.process(app);
+
+	QStringList args = parser.positionalArguments();
+	if(args.size() != 1) {
+		fprintf(stderr, "nailart-batch: expected one input\n");
+		parser.showHelp(255);
+	}
+
+	// collect default parameters from the command line
+	PipelineParams defaults;
+	QString unused;
+	const QCommandLineOption *opts[] = {
+		&optWidth, &optHeight, &optGauge, &optBrightness,
+		&optContrast, &optGamma, &optSize, &optFactor, &optEngine,
+		&optScan, 0
+	};
+	for(int i=0; opts[i]; i++) {
+		QString key = opts[i]->names().first();
+		if(!setParam(key, parser.value(*opts[i]), defaults, unused)) {
+			fprintf(stderr, "nailart-batch: bad value for --%s: %s\n",
+				qPrintable(key), qPrintable(parser.value(*opts[i])));
+			return 255;
+		}
+	}
+
+	QDir outDir(parser.value(optOutput));
+	if(!outDir.exists() && !QDir().mkpath(outDir.path())) {
+		fprintf(stderr, "nailart-batch: cannot create %s\n",
+			qPrintable(outDir.path()));
+		return 255;
+	}
+
+	// build job list from input directory or manifest
+	QVector<BatchJob*> jobs;
+	bool stream = parser.isSet(optStream);
+	QFileInfo input(args[0]);
+	if(input.isDir()) {
+		QStringList filters;
+		for(int i=0; ImageFilters[i]; i++)
+			filters << ImageFilters[i];
+		QDir dir(input.filePath());
+		QStringList files = dir.entryList(filters, QDir::Files, QDir::Name);
+		for(int i=0; i<files.size(); i++) {
+			QString image = dir.filePath(files[i]);
+			jobs.append(new BatchJob(image, outputFile(image, "", outDir),
+						 defaults, stream));
+		}
+	} else if(!readManifest(input.filePath(), defaults, outDir, stream, jobs)) {
+		return 255;
+	}
+
+	// run jobs on all cores
+	QThreadPool pool;
+	if(parser.isSet(optJobs))
+		pool.setMaxThreadCount(qMax(1, parser.value(optJobs).toInt()));
+
+	QElapsedTimer timer;
+	timer.start();
+	for(int i=0; i<jobs.size(); i++)
+		pool.start(jobs[i]);
+	pool.waitForDone();
+
+	// summary
+	int failed = 0;
+	long long nails = 0;
+	for(int i=0; i<jobs.size(); i++) {
+		if(jobs[i]->ok()) nails += jobs[i]->nails();
+		else		  failed++;
+		delete jobs[i];
+	}
+	printf("%d jobs, %d failed, %lld nails, %lld ms on %d threads\n",
+	       jobs.size(), failed, nails, (long long) timer.elapsed(),
+	       pool.maxThreadCount());
+
+	return qMin(failed, 255);
+}
@@ -0,0 +1,120 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// TestBilateral.cpp - Bilateral grid checks
+//
+// IP_blurBilateralGrid() approximates the exact IP_blurBilateral(): its
+// PSNR against the exact filter must stay above a bound that rises with
+// the grid resolution. Where sigmaS < res it uses the exact filter and
+// must match it. The result may not depend on the thread count or on
+// filtering in place.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <cmath>
+#include "Tests.h"
+
+// least PSNR (dB) of the grid against the exact filter, for res 1 and 2;
+// the test images come within about 42 dB (noise) and 47 dB (ramp)
+static const double MinPSNR[] = { 0, 40, 45 };
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// psnr:
+//
+// Return the PSNR of uchar image I2 against I1 in dB, or 99 if they are
+// equal.
+//
+static double
+psnr(const ImagePtr &I1, const ImagePtr &I2)
+{
+	int    n   = I1->width() * I1->height();
+	double sse = 0;
+	for(int ch=0; ch<I1->maxChannel(); ch++) {
+		ChannelPtr<uchar> p1 = (*I1)[ch], p2 = (*I2)[ch];
+		for(int i=0; i<n; i++) {
+			double d = p1[i] - p2[i];
+			sse += d*d;
+		}
+	}
+	if(!sse) return 99;
+	n *= I1->maxChannel();
+	return 10 * log10((double) MaxGray*MaxGray * n / sse);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testBilateralImage:
+//
+// Compare IP_blurBilateralGrid() with IP_blurBilateral() on image I for
+// sigmaS, sigmaR and res 1 and 2. Return the number of failures.
+//
+static int
+testBilateralImage(const ImagePtr &I, double sigmaS, double sigmaR)
+{
+	int failures = 0;
+	ImagePtr E;
+	if(!IP_blurBilateral(I, sigmaS, sigmaR, E, 2)) {
+		TEST_CHECK(0, "IP_blurBilateral failed");
+		return failures;
+	}
+
+	for(int res=1; res<=2; res++) {
+		ImagePtr G;
+		if(!IP_blurBilateralGrid(I, sigmaS, sigmaR, G, res, 3)) {
+			TEST_CHECK(0, "IP_blurBilateralGrid failed");
+			return failures;
+		}
+
+		double db = psnr(E, G);
+		if(sigmaS < res)
+			TEST_CHECK(db == 99, "sigmaS %g, res %d: not the exact "
+				   "filter (%.1f dB)", sigmaS, res, db);
+		else
+			TEST_CHECK(db >= MinPSNR[res], "sigmaS %g, sigmaR %g, "
+				   "res %d: PSNR %.1f dB", sigmaS, sigmaR, res, db);
+
+		// thread count and in place
+		ImagePtr T, J;
+		IP_blurBilateralGrid(I, sigmaS, sigmaR, T, res, 1);
+		TEST_CHECK(testSame(G, T), "sigmaS %g, res %d: thread count "
+			   "changes result", sigmaS, res);
+		IP_copyImage(I, J);
+		IP_blurBilateralGrid(J, sigmaS, sigmaR, J, res, 2);
+		TEST_CHECK(testSame(G, J), "sigmaS %g, res %d: in-place result "
+			   "differs", sigmaS, res);
+	}
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testBilateral:
+//
+// Compare the bilateral grid with the exact filter on the test images,
+// gray and color. The exact filter is slow, so images are small.
+//
+int
+testBilateral()
+{
+	srand(5);
+	int failures = 0;
+	static const double sigmas[][2] = {	// sigmaS, sigmaR
+		{ 1.5, 20 }, { 4, 15 }, { 4, 30 }, { 8, 30 }
+	};
+	for(int k=0; k<TEST_KINDS; k++) {
+		for(int i=0; i<4; i++) {
+			int w = 100 + rand()%60;
+			int h = 80  + rand()%40;
+			ImagePtr I;
+			testImage(I, w, h, (i & 1) ? RGB_TYPE : BW_TYPE, k, rand());
+			failures += testBilateralImage(I, sigmas[i][0], sigmas[i][1]);
+		}
+	}
+	return failures;
+}
@@ -0,0 +1,142 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// TestDither.cpp - Error diffusion checks
+//
+// The DIFFUSE_EXACT engine must reproduce IP_ditherDiffuse() bit for bit:
+// through IP_ditherDiffuseMT() for every thread count, and through
+// IP_diffuseChannel() and DiffuseRows, which do not delegate serial scans
+// to the library, with IP::Serpentine both clear and set. An explicit
+// scan order must give the same output whatever IP::Serpentine says.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <cstring>
+#include <vector>
+#include "Tests.h"
+
+static const int Methods[] = {
+	FLOYD_STEINBERG, JARVIS_JUDICE_NINKE, FAN, STUCKI, BURKES, SIERRA,
+	STEVENSON_ARCE
+};
+static const double Gammas[] = { 1, .5, 1.4, 2.2, 0, -1 };
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testDitherImage:
+//
+// Compare the engines with IP_ditherDiffuse() on image I for method and
+// gamma. Return the number of failures.
+//
+static int
+testDitherImage(const ImagePtr &I, int method, double gamma)
+{
+	int failures = 0;
+	int w = I->width();
+	int h = I->height();
+
+	ImagePtr R;
+	std::vector<int> refRows(h);
+	IP_ditherDiffuse(I, method, gamma, R);
+	int black = IP_countDiffuseRows(R, &refRows[0]);
+	ChannelPtr<uchar> ref = (*R)[0];
+
+	// whole images, counting black pixels
+	static const int threads[] = { 1, 2, 3, 4 };
+	for(int i=0; i<4; i++) {
+		ImagePtr O;
+		std::vector<int> rows(h);
+		int n = IP_ditherDiffuseMT(I, method, gamma, O, threads[i],
+					   DIFFUSE_EXACT, &rows[0]);
+		TEST_CHECK(testSame(R, O),
+			   "IP_ditherDiffuseMT differs: method %d, %d threads",
+			   method, threads[i]);
+		TEST_CHECK(n == black, "black count %d, expected %d", n, black);
+		TEST_CHECK(rows == refRows, "row counts differ: method %d, "
+			   "%d threads", method, threads[i]);
+	}
+
+	// explicit scan order, the other way round from IP::Serpentine
+	int scan = IP::Serpentine ? DIFFUSE_SERPENTINE : DIFFUSE_RASTER;
+	IP::Serpentine = !IP::Serpentine;
+	for(int i=0; i<4; i+=3) {
+		ImagePtr O;
+		std::vector<int> rows(h);
+		int n = IP_ditherDiffuseMT(I, method, gamma, O, threads[i],
+					   DIFFUSE_EXACT, &rows[0], scan);
+		TEST_CHECK(testSame(R, O), "scan %d differs: method %d, "
+			   "%d threads", scan, method, threads[i]);
+		TEST_CHECK(n == black, "scan %d black count %d, expected %d",
+			   scan, n, black);
+		TEST_CHECK(rows == refRows, "scan %d row counts differ: "
+			   "method %d", scan, method);
+	}
+	IP::Serpentine = !IP::Serpentine;
+
+	// in place
+	ImagePtr J;
+	IP_copyImage(I, J);
+	IP_ditherDiffuseMT(J, method, gamma, J, 2);
+	TEST_CHECK(testSame(R, J), "in-place dither differs: method %d", method);
+
+	// channel engine, serial scans included
+	uchar lut[MXGRAY];
+	short lutFixed[MXGRAY];
+	IP_diffuseLut(gamma, lut, lutFixed);
+	const DiffuseKernel *k = IP_diffuseKernel(method);
+	ChannelPtr<uchar> in = (*I)[0];
+	std::vector<uchar> out(w*h);
+	for(int i=0; i<4; i++) {
+		int n = IP_diffuseChannel(in.buf(), w, h, lut, k, &out[0],
+					  threads[i]);
+		TEST_CHECK(!memcmp(&out[0], ref.buf(), w*h),
+			   "IP_diffuseChannel differs: method %d, %d threads",
+			   method, threads[i]);
+		TEST_CHECK(n == black, "channel black count %d, expected %d",
+			   n, black);
+	}
+
+	// row engine
+	DiffuseRows dr(k, w, gamma, DIFFUSE_EXACT);
+	for(int y=0; y<h; y++)
+		dr.next(in.buf() + y*w, &out[y*w]);
+	TEST_CHECK(!memcmp(&out[0], ref.buf(), w*h),
+		   "DiffuseRows differs: method %d", method);
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testDither:
+//
+// Dither gray and color test images of random sizes with every kernel
+// and a range of gammas (0 and below are clamped as the library does),
+// with serpentine scans off and on.
+//
+int
+testDither()
+{
+	int failures = 0;
+	int serpentine = IP::Serpentine;
+	srand(1);
+	for(int s=0; s<2; s++) {
+		IP::Serpentine = s;
+		for(int m=0; m<7; m++) {
+			for(int t=0; t<12; t++) {
+				int w = 1 + rand()%150;
+				int h = 1 + rand()%90;
+				unsigned seed = rand();
+				ImagePtr I;
+				testImage(I, w, h, (t%3) ? BW_TYPE : RGB_TYPE,
+					  t%TEST_KINDS, seed);
+				failures += testDitherImage(I, Methods[m], Gammas[t%6]);
+			}
+		}
+	}
+	IP::Serpentine = serpentine;
+	return failures;
+}
@@ -0,0 +1,111 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// TestGauss.cpp - Recursive Gaussian checks
+//
+// IP_blurGaussianIIR() approximates the full Gaussian and
+// IP_blurGaussian() a truncated one, so for sigma >= 3 they must agree
+// within a few gray levels, pixel by pixel and in RMS. Below sigma 3 it
+// passes the image on to the library and must reproduce it exactly. The
+// result may not depend on the thread count or on blurring in place.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <cmath>
+#include <cstring>
+#include "Tests.h"
+
+// bounds against IP_blurGaussian(): largest difference, RMS difference
+#define GAUSS_MAX_TOL	5
+#define GAUSS_RMS_TOL	1.9
+
+static const double Sigmas[] = { 4, 6.5, 8, 12, 16, 24, 32 };
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testGaussImage:
+//
+// Compare IP_blurGaussianIIR() with IP_blurGaussian() on image I for
+// sigma. Return the number of failures.
+//
+static int
+testGaussImage(const ImagePtr &I, double sigma)
+{
+	int failures = 0;
+	int w = I->width();
+	int h = I->height();
+	int n = w * h;
+
+	ImagePtr R, O;
+	IP_blurGaussian(I, sigma, R);
+	IP_blurGaussianIIR(I, sigma, O, 3);
+	if(sigma < 3) {
+		TEST_CHECK(testSame(R, O), "sigma %g: not passed on to the library",
+			   sigma);
+		return failures;
+	}
+
+	int    worst = 0;
+	double sse   = 0;
+	for(int ch=0; ch<I->maxChannel(); ch++) {
+		ChannelPtr<uchar> r = (*R)[ch], o = (*O)[ch];
+		for(int i=0; i<n; i++) {
+			int d = ABS(o[i] - r[i]);
+			worst = MAX(worst, d);
+			sse  += d*d;
+		}
+	}
+	double rms = sqrt(sse / ((double) n * I->maxChannel()));
+	TEST_CHECK(worst <= GAUSS_MAX_TOL, "sigma %g, %dx%d: max difference %d",
+		   sigma, w, h, worst);
+	TEST_CHECK(rms <= GAUSS_RMS_TOL, "sigma %g, %dx%d: RMS difference %.3f",
+		   sigma, w, h, rms);
+
+	// thread counts and in place
+	for(int threads=1; threads<=4; threads+=3) {
+		ImagePtr T;
+		IP_blurGaussianIIR(I, sigma, T, threads);
+		TEST_CHECK(testSame(O, T), "sigma %g: %d threads differ",
+			   sigma, threads);
+	}
+	ImagePtr J;
+	IP_copyImage(I, J);
+	IP_blurGaussianIIR(J, sigma, J, 2);
+	TEST_CHECK(testSame(O, J), "sigma %g: in-place blur differs", sigma);
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testGauss:
+//
+// Compare the recursive Gaussian with the library on the test images,
+// gray and color, for sigma 4 to 32 and for sigmas and kernel sizes
+// it passes on.
+//
+int
+testGauss()
+{
+	srand(4);
+	int failures = 0;
+	for(int k=0; k<TEST_KINDS; k++) {
+		for(int i=0; i<(int) (sizeof(Sigmas) / sizeof(Sigmas[0])); i++) {
+			int w = 120 + rand()%200;
+			int h = 120 + rand()%150;
+			ImagePtr I;
+			testImage(I, w, h, (i & 1) ? RGB_TYPE : BW_TYPE, k, rand());
+			failures += testGaussImage(I, Sigmas[i]);
+		}
+	}
+
+	ImagePtr I;
+	testImage(I, 97, 61, BW_TYPE, TEST_NOISE, 5);
+	failures += testGaussImage(I, 1.5);
+	failures += testGaussImage(I, -9);	// kernel size 9: sigma 1.8
+	failures += testGaussImage(I, -8);	// even size, passed on as is
+	return failures;
+}
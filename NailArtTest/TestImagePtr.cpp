@@ -0,0 +1,149 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// TestImagePtr.cpp - ImagePtr reference counting and moves
+//
+// Copies, moves and assignments of ImagePtrs to a few images, in a
+// pseudo-random order. Every link taken must be given back: the images
+// end with the links of their owners only and unchanged pixels. A
+// moved-from ImagePtr must be null. The count is not atomic (the
+// prebuilt library has its own copies of the Image and ImagePtr code),
+// so all of this runs on one thread.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <utility>
+#include "Tests.h"
+
+#define PTR_IMAGES	4
+#define PTR_ITERS	100000
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// imageSum:
+//
+// Return the sum of the pixels of uchar image I.
+//
+static long
+imageSum(const ImagePtr &I)
+{
+	ChannelPtr<uchar> p = (*I)[0];
+	int  n	 = I->width() * I->height();
+	long sum = 0;
+	for(int i=0; i<n; i++) sum += p[i];
+	return sum;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testMoves:
+//
+// Check that moves transfer the image without changing its link count
+// and leave the source null. Return the number of failures.
+//
+static int
+testMoves(const ImagePtr &I)
+{
+	int failures = 0;
+	int links = I->links();
+
+	ImagePtr a(I);
+	ImagePtr b(std::move(a));
+	TEST_CHECK(a.isNull(), "moved-from ImagePtr is not null");
+	TEST_CHECK(b == I && I->links() == links+1,
+		   "move constructor: %d links, expected %d",
+		   I->links(), links+1);
+
+	ImagePtr c;
+	c = std::move(b);
+	TEST_CHECK(b.isNull(), "move-assigned-from ImagePtr is not null");
+	TEST_CHECK(c == I && I->links() == links+1,
+		   "move assignment: %d links, expected %d",
+		   I->links(), links+1);
+
+	// a moved-from ImagePtr may be assigned again
+	a = c;
+	TEST_CHECK(a == I && I->links() == links+2,
+		   "assignment after move: %d links, expected %d",
+		   I->links(), links+2);
+
+	a = ImagePtr();
+	c = ImagePtr();
+	TEST_CHECK(I->links() == links, "%d links left, expected %d",
+		   I->links(), links);
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testImagePtr:
+//
+// Take and drop links to PTR_IMAGES images in a pseudo-random order,
+// checking the first pixel of each image through its links, then check
+// the link counts and pixels of the images. Images whose last link is
+// dropped here are freed; run under a leak checker for full effect.
+//
+int
+testImagePtr()
+{
+	int failures = 0;
+
+	ImagePtr src[PTR_IMAGES];
+	uchar	 first[PTR_IMAGES];
+	long	 sum  [PTR_IMAGES];
+	for(int k=0; k<PTR_IMAGES; k++) {
+		testImage(src[k], 64, 64, BW_TYPE, TEST_NOISE, 10 + k);
+		ChannelPtr<uchar> p = (*src[k])[0];
+		first[k] = p[0];
+		sum  [k] = imageSum(src[k]);
+	}
+	failures += testMoves(src[0]);
+
+	ImagePtr local[3];
+	unsigned seed = 7;
+	int	 bad  = 0;
+	for(int i=0; i<PTR_ITERS; i++) {
+		seed = seed*1103515245 + 12345;
+		int k = (seed >> 16) % PTR_IMAGES;
+		int j = (seed >>  8) % 3;
+		int m = (j+1) % 3;
+		ImagePtr t(src[k]);
+		switch(i % 5) {
+		case 0: local[j] = src[k];		break;	// copy
+		case 1: local[j] = std::move(t);	break;	// move
+		case 2: local[j] = local[m];		break;	// copy, maybe last
+		case 3: local[j] = std::move(local[m]);	break;	// move, maybe last
+		case 4: local[j] = ImagePtr();		break;	// drop
+		}
+		for(int n=0; n<3; n++) {
+			if(local[n].isNull()) continue;
+			ChannelPtr<uchar> p = (*local[n])[0];
+			int idx;
+			for(idx=0; idx<PTR_IMAGES && src[idx] != local[n]; idx++);
+			if(idx == PTR_IMAGES || p[0] != first[idx]) bad++;
+		}
+	}
+	TEST_CHECK(!bad, "%d reads through links hit the wrong image", bad);
+
+	for(int n=0; n<3; n++) local[n] = ImagePtr();
+	for(int k=0; k<PTR_IMAGES; k++) {
+		TEST_CHECK(src[k]->links() == 1,
+			   "image %d has %d links, expected 1", k, src[k]->links());
+		TEST_CHECK(imageSum(src[k]) == sum[k], "image %d changed", k);
+	}
+
+	// last links dropped by assignment and by destruction
+	for(int t=0; t<8; t++) {
+		ImagePtr I, J;
+		testImage(I, 32, 32, BW_TYPE, TEST_NOISE, t);
+		J = I;
+		I = ImagePtr();
+		if(t & 1) J = ImagePtr();
+	}
+	return failures;
+}
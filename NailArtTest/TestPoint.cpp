@@ -0,0 +1,121 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// TestPoint.cpp - Lookup table point operation checks
+//
+// Each IP_*Fast() function of IPpoint.tpp must reproduce the library
+// point operation it is named after bit for bit on uchar images: the
+// tables have to truncate and clip where the library does. Parameters
+// include the degenerate ones (gamma <= 0, negative factors, reversed
+// and out-of-range thresholds).
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include "Tests.h"
+
+static const double Contrasts[][3] = {		// brightness, contrast, ref
+	{ 0, 1, 128 }, { 10, 1.2, 128 }, { -30, .7, 100 }, { 25.5, 2.5, 64 },
+	{ 0, -1, 128 }, { 40, .33, 0 }, { -200, 3, 128 }, { 0, 0, 127.5 }
+};
+static const double Gammas[] = { 1, .5, 1.4, 2.2, .3, 0, -1 };
+static const double Clips[][2] = {		// t1, t2
+	{ 0, 255 }, { 50.7, 200.2 }, { 100, 100 }, { -10, 300 }, { 200, 50 }
+};
+static const double Ranges[][2] = {		// t1, t2
+	{ 0, 255 }, { 10.5, 200.9 }, { 255, 0 }, { 30, 30 }, { 1, 254 }
+};
+static const double Adds[] = { 0, 10.5, -20.3, 300, -300, .999 };
+static const double Mults[] = { 1, .5, 1.7, 0, -.5, -2, 1.001 };
+
+#define COUNT(a)	((int) (sizeof(a) / sizeof(a[0])))
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testPointImage:
+//
+// Compare the IP_*Fast() functions with the library on uchar image I
+// for every parameter above. Return the number of failures.
+//
+static int
+testPointImage(const ImagePtr &I)
+{
+	int failures = 0;
+	int nch = I->maxChannel();
+	ImagePtr R, F;
+
+	for(int i=0; i<COUNT(Contrasts); i++) {
+		const double *p = Contrasts[i];
+		IP_contrast	(I, p[0], p[1], p[2], R);
+		IP_contrastFast (I, p[0], p[1], p[2], F);
+		TEST_CHECK(testSame(R, F), "IP_contrastFast differs: %g, %g, %g",
+			   p[0], p[1], p[2]);
+	}
+	for(int i=0; i<COUNT(Gammas); i++) {
+		IP_gammaCorrect	   (I, Gammas[i], R);
+		IP_gammaCorrectFast(I, Gammas[i], F);
+		TEST_CHECK(testSame(R, F), "IP_gammaCorrectFast differs: %g",
+			   Gammas[i]);
+	}
+	for(int i=0; i<COUNT(Clips); i++) {
+		IP_clip	   (I, Clips[i][0], Clips[i][1], R);
+		IP_clipFast(I, Clips[i][0], Clips[i][1], F);
+		TEST_CHECK(testSame(R, F), "IP_clipFast differs: %g, %g",
+			   Clips[i][0], Clips[i][1]);
+	}
+	for(int i=0; i<COUNT(Ranges); i++) {
+		IP_scaleRange	 (I, Ranges[i][0], Ranges[i][1], R);
+		IP_scaleRangeFast(I, Ranges[i][0], Ranges[i][1], F);
+		TEST_CHECK(testSame(R, F), "IP_scaleRangeFast differs: %g, %g",
+			   Ranges[i][0], Ranges[i][1]);
+	}
+
+	// a different constant for each channel
+	double c[MXCHANNEL];
+	for(int i=0; i<COUNT(Adds); i++) {
+		for(int ch=0; ch<nch; ch++) c[ch] = Adds[(i+ch) % COUNT(Adds)];
+		IP_addConst    (I, c, R);
+		IP_addConstFast(I, c, F);
+		TEST_CHECK(testSame(R, F), "IP_addConstFast differs: %g", c[0]);
+	}
+	for(int i=0; i<COUNT(Mults); i++) {
+		for(int ch=0; ch<nch; ch++) c[ch] = Mults[(i+ch) % COUNT(Mults)];
+		IP_multiplyConst    (I, c, R);
+		IP_multiplyConstFast(I, c, F);
+		TEST_CHECK(testSame(R, F), "IP_multiplyConstFast differs: %g",
+			   c[0]);
+	}
+
+	// in place
+	IP_contrast(I, 10, 1.2, 128, R);
+	IP_copyImage(I, F);
+	IP_contrastFast(F, 10, 1.2, 128, F);
+	TEST_CHECK(testSame(R, F), "in-place IP_contrastFast differs");
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testPoint:
+//
+// Compare the lookup table point operations with the library on random
+// gray and color images of random sizes, and on the other test images.
+//
+int
+testPoint()
+{
+	srand(3);
+	int failures = 0;
+	for(int t=0; t<24; t++) {
+		int w	 = 16 + rand()%200;
+		int h	 = 16 + rand()%150;
+		int kind = (t < 16) ? TEST_NOISE : t % TEST_KINDS;
+		ImagePtr I;
+		testImage(I, w, h, (t & 1) ? RGB_TYPE : BW_TYPE, kind, rand());
+		failures += testPointImage(I);
+	}
+	return failures;
+}
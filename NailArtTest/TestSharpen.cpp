@@ -0,0 +1,92 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// TestSharpen.cpp - Multithreaded blur and sharpen checks
+//
+// IP_blurMT() and IP_sharpenMT() must reproduce IP_blur() and
+// IP_sharpen() exactly, for the filter sizes and factors the GUI offers
+// (1 to 100), odd, even and fractional, square or not, for every thread
+// count, and in place.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include "Tests.h"
+
+static const double Sizes[][2] = {	// filter width, height
+	{ 1, 1 }, { 2, 2 }, { 3, 3 }, { 4.5, 4.5 }, { 7, 2 }, { 1, 9 },
+	{ 16, 16 }, { 33.3, 25 }, { 64, 64 }, { 100, 100 }
+};
+static const double Factors[] = { 1, 2.5, 10, 100 };
+static const int    Threads[] = { 1, 2, 3, 0 };
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testSharpenImage:
+//
+// Compare IP_blurMT() with IP_blur() and IP_sharpenMT() with
+// IP_sharpen() on image I for filter size xsz x ysz and factor fctr.
+// Return the number of failures.
+//
+static int
+testSharpenImage(const ImagePtr &I, double xsz, double ysz, double fctr)
+{
+	int failures = 0;
+	ImagePtr B, S;
+	IP_blur   (I, xsz, ysz, B);
+	IP_sharpen(I, xsz, ysz, fctr, S);
+
+	for(int t=0; t<4; t++) {
+		ImagePtr O;
+		IP_blurMT(I, xsz, ysz, O, Threads[t]);
+		TEST_CHECK(testSame(B, O), "IP_blurMT differs: %dx%d, %gx%g, "
+			   "%d threads", I->width(), I->height(), xsz, ysz,
+			   Threads[t]);
+		IP_sharpenMT(I, xsz, ysz, fctr, O, Threads[t]);
+		TEST_CHECK(testSame(S, O), "IP_sharpenMT differs: %dx%d, %gx%g, "
+			   "factor %g, %d threads", I->width(), I->height(),
+			   xsz, ysz, fctr, Threads[t]);
+	}
+
+	// in place
+	ImagePtr J;
+	IP_copyImage(I, J);
+	IP_blurMT(J, xsz, ysz, J, 2);
+	TEST_CHECK(testSame(B, J), "in-place IP_blurMT differs: %gx%g",
+		   xsz, ysz);
+	IP_copyImage(I, J);
+	IP_sharpenMT(J, xsz, ysz, fctr, J, 2);
+	TEST_CHECK(testSame(S, J), "in-place IP_sharpenMT differs: %gx%g, "
+		   "factor %g", xsz, ysz, fctr);
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testSharpen:
+//
+// Blur and sharpen the test images, of random sizes that the larger
+// filters may exceed (IP_blur() then copies the image), with every
+// filter size and factor.
+//
+int
+testSharpen()
+{
+	srand(6);
+	int failures = 0;
+	for(int k=0; k<TEST_KINDS; k++) {
+		int w = 60 + rand()%120;
+		int h = 50 + rand()%100;
+		ImagePtr I;
+		testImage(I, w, h, BW_TYPE, k, rand());
+		for(int i=0; i<10; i++)
+			for(int j=0; j<4; j++)
+				failures += testSharpenImage(I, Sizes[i][0],
+							     Sizes[i][1],
+							     Factors[j]);
+	}
+	return failures;
+}
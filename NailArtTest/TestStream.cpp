@@ -0,0 +1,230 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// TestStream.cpp - StreamPipeline checks against Pipeline
+//
+// AreaRows must reproduce AreaTable::resize(), and BlurRows the column
+// blur of IP_blur1D(). StreamPipeline must give the nail map of Pipeline
+// when an image is shrunk, sharpened or not, and stay close to it when
+// it is enlarged (see StreamPipeline): the nail counts of the whole map
+// and of 8x8 blocks are compared.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <cstring>
+#include <vector>
+#include "Tests.h"
+#include "Pipeline.h"
+#include "StreamPipeline.h"
+
+// bounds for enlarged maps: relative nail count difference,
+// and nail count difference of an 8x8 block
+#define STREAM_COUNT_TOL	.02
+#define STREAM_BLOCK_TOL	12
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testAreaRows:
+//
+// Compare AreaRows with AreaTable::resize() on random sizes and luts,
+// and check the size limit of 32-bit area sums at its boundary.
+// Return the number of failures.
+//
+static int
+testAreaRows()
+{
+	int failures = 0;
+	TEST_CHECK( IP_areaFits(4096, 4095, 1, 1), "4096x4095 sum rejected");
+	TEST_CHECK(!IP_areaFits(4096, 4096, 1, 1), "4096x4096 sum accepted");
+	TEST_CHECK( IP_areaFits(8000, 6000, 2, 2), "8000x6000 to 2x2 rejected");
+	TEST_CHECK(!IP_areaFits(10000, 5000, 1, 2), "10000x5000 to 1x2 accepted");
+	for(int t=0; t<50; t++) {
+		int sw = 1 + rand()%200;
+		int sh = 1 + rand()%200;
+		int w  = 1 + rand()%sw;
+		int h  = 1 + rand()%sh;
+		ImagePtr I;
+		testImage(I, sw, sh, BW_TYPE, t%TEST_KINDS, rand());
+
+		uchar lut[MXGRAY];
+		for(int i=0; i<MXGRAY; i++) lut[i] = (uchar) (MaxGray - i);
+		const uchar *l = (t & 1) ? lut : NULL;
+
+		AreaTable table;
+		ImagePtr  R;
+		table.build(I);
+		table.resize(w, h, R, l);
+
+		ChannelPtr<uchar> p = (*I)[0], ref = (*R)[0];
+		AreaRows rows(p.buf(), sw, sh, w, h);
+		std::vector<uchar> out(w);
+		for(int y=0; y<h; y++) {
+			rows.next(&out[0], l);
+			if(memcmp(&out[0], ref.buf() + y*w, w)) {
+				TEST_CHECK(0, "AreaRows differs: %dx%d -> %dx%d, row %d",
+					   sw, sh, w, h, y);
+				break;
+			}
+		}
+	}
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testBlurRows:
+//
+// Compare BlurRows with IP_blur1DScratch() down every column, on random
+// sizes and odd, even and fractional filter widths.
+// Return the number of failures.
+//
+static int
+testBlurRows()
+{
+	int failures = 0;
+	for(int t=0; t<200; t++) {
+		int len = 2 + rand()%120;
+		int n	= 1 + rand()%40;
+		double ww = 1 + rand() % MIN(len, 30);
+		if(t % 3) ww += (rand() % 4 + 1) / 5.;
+		if(ww > len) ww = len;
+		if(ww <= 1) ww = 2;
+
+		std::vector<uchar> in((size_t) len*n), ref((size_t) len*n);
+		std::vector<uchar> out((size_t) len*n, 0);
+		for(size_t i=0; i<in.size(); i++) in[i] = (uchar) rand();
+		for(int x=0; x<n; x++)
+			IP_blur1DScratch(ChannelPtr<uchar>(&in[x]), len, n, ww,
+					 ChannelPtr<uchar>(&ref[x]));
+
+		// blurred rows must come out in order
+		BlurRows rows(len, n, ww);
+		std::vector<uchar> row(n);
+		int next = 0;
+		auto take = [&](int r) {
+			if(r < 0 || r != next) return;
+			memcpy(&out[(size_t) r*n], &row[0], n);
+			next++;
+		};
+		for(int y=0; y<len; y++)
+			take(rows.push(&in[(size_t) y*n], &row[0]));
+		for(int r; (r = rows.flush(&row[0])) >= 0; ) take(r);
+		TEST_CHECK(next == len && out == ref,
+			   "BlurRows differs: %d rows of %d, width %g",
+			   len, n, ww);
+	}
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testStreamImage:
+//
+// Run Pipeline and StreamPipeline on I with params. If exact is set the
+// nail maps must be equal, else close. Return the number of failures.
+//
+static int
+testStreamImage(const ImagePtr &I, const PipelineParams &params, bool exact)
+{
+	int failures = 0;
+	Pipeline       pipe;
+	StreamPipeline stream;
+	ImagePtr       P, S;
+	bool ok1 = pipe  .run(I, params, P);
+	bool ok2 = stream.run(I, params, S);
+	TEST_CHECK(ok1 && ok2, "pipeline failed");
+	if(!ok1 || !ok2) return failures;
+
+	int w = P->width();
+	int h = P->height();
+	TEST_CHECK(w == S->width() && h == S->height(), "sizes differ");
+	if(failures) return failures;
+
+	if(exact) {
+		TEST_CHECK(testSame(P, S),
+			   "nail maps differ: %dx%d -> %dx%d",
+			   I->width(), I->height(), w, h);
+		TEST_CHECK(pipe.nails() == stream.nails() &&
+			   pipe.rowNails() == stream.rowNails(),
+			   "nail counts differ: %d, %d",
+			   pipe.nails(), stream.nails());
+		return failures;
+	}
+
+	// whole map and 8x8 blocks
+	int diff = ABS(pipe.nails() - stream.nails());
+	TEST_CHECK(diff <= STREAM_COUNT_TOL * w*h,
+		   "nail counts %d and %d of %d pixels",
+		   pipe.nails(), stream.nails(), w*h);
+
+	ChannelPtr<uchar> p = (*P)[0], s = (*S)[0];
+	int worst = 0;
+	for(int y0=0; y0+8<=h; y0+=8) {
+		for(int x0=0; x0+8<=w; x0+=8) {
+			int d = 0;
+			for(int y=y0; y<y0+8; y++)
+				for(int x=x0; x<x0+8; x++)
+					d += !p[y*w + x] - !s[y*w + x];
+			worst = MAX(worst, ABS(d));
+		}
+	}
+	TEST_CHECK(worst <= STREAM_BLOCK_TOL,
+		   "8x8 block nail counts differ by %d", worst);
+	return failures;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testStream:
+//
+// Compare the pipelines on shrunk and enlarged test images, with and
+// without sharpening, and check AreaRows and BlurRows. Filter sizes are
+// odd, even, fractional, and larger than the map (no sharpening).
+//
+int
+testStream()
+{
+	srand(2);
+	int failures = testAreaRows();
+	failures += testBlurRows();
+
+	PipelineParams params;
+	params.spacing	  = 1;
+	params.brightness = 10;
+	params.contrast	  = 20;
+	params.gamma	  = 1.2;
+	params.engine	  = DIFFUSE_EXACT;
+	params.scan	  = DIFFUSE_LIBRARY;
+
+	static const int sizes[][2] = {		// source size, art width
+		{ 400, 120 }, { 333, 97 }, { 257, 256 }, { 60, 150 }
+	};
+	static const double filters[][2] = {	// filter size, factor
+		{ 1, 1 }, { 5, 3 }, { 4, 100 }, { 2.5, 1.5 }, { 200, 2 }
+	};
+	for(int i=0; i<4; i++) {
+		for(int k=0; k<TEST_KINDS; k++) {
+			int sw = sizes[i][0];
+			int sh = sizes[i][0] * 3/4;
+			ImagePtr I;
+			testImage(I, sw, sh, BW_TYPE, k, rand());
+
+			params.artWidth  = sizes[i][1];
+			params.artHeight = sizes[i][1] * 3/4;
+			bool shrink = (sizes[i][1] <= sw);
+
+			for(int j=0; j<5; j++) {
+				params.filterSize = filters[j][0];
+				params.filterFctr = filters[j][1];
+				failures += testStreamImage(I, params, shrink);
+			}
+		}
+	}
+	return failures;
+}
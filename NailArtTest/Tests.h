@@ -0,0 +1,45 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// Tests.h - Header file for the nailart-test checks
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <cstdio>
+#include "IP.h"
+
+using namespace IP;
+
+// a check fails by printing where and why, and counting one failure
+#define TEST_CHECK(cond, ...)						\
+	do {								\
+		if(!(cond)) {						\
+			fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);	\
+			fprintf(stderr, __VA_ARGS__);			\
+			fprintf(stderr, "\n");				\
+			++failures;					\
+		}							\
+	} while(0)
+
+// test images: random noise, horizontal ramp, checkerboard, flat gray
+enum test_images { TEST_NOISE, TEST_RAMP, TEST_CHECKER, TEST_FLAT, TEST_KINDS };
+
+extern void	testImage (ImagePtr, int w, int h, int *types, int kind,
+			   unsigned seed);
+extern bool	testSame  (const ImagePtr&, const ImagePtr&);
+
+// each test returns its number of failures
+extern int	testDither();
+extern int	testStream();
+extern int	testImagePtr();
+extern int	testPoint();
+extern int	testGauss();
+extern int	testBilateral();
+extern int	testSharpen();
+
+#endif // TESTS_H
@@ -0,0 +1,127 @@
+// ======================================================================
+// Nail Art Design and Rendering Package
+// Copyright (C) 2015 by George Wolberg
+//
+// main.cpp - main() function for nailart-test.
+//
+// Usage: nailart-test [test ...]
+//
+// Check the multithreaded and streaming image operations of the nail art
+// pipeline against the IP library functions they replace. With no
+// arguments all tests are run; otherwise only the named ones.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+#include <cstdlib>
+#include <cstring>
+#include "Tests.h"
+
+struct TestEntry {
+	const char	*name;
+	int		(*run)();
+};
+
+static const TestEntry Tests[] = {
+	{ "dither",	testDither },
+	{ "stream",	testStream },
+	{ "imageptr",	testImagePtr },
+	{ "point",	testPoint },
+	{ "gauss",	testGauss },
+	{ "bilateral",	testBilateral },
+	{ "sharpen",	testSharpen },
+	{ 0, 0 }
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testImage:
+//
+// Allocate I as a w x h image with channel types and fill its channels
+// with a test pattern of the given kind (test_images). Noise depends on
+// seed only, so failures can be reproduced.
+//
+void
+testImage(ImagePtr I, int w, int h, int *types, int kind, unsigned seed)
+{
+	IP_allocImageInI(I, w, h, types);
+	srand(seed);
+
+	ChannelPtr<uchar> p;
+	int type;
+	for(int ch=0; IP_getChannel(I, ch, p, type); ch++) {
+		for(int y=0; y<h; y++) {
+			for(int x=0; x<w; x++) {
+				int v;
+				switch(kind) {
+				case TEST_NOISE:   v = rand() % MXGRAY;			break;
+				case TEST_RAMP:	   v = x*MaxGray / MAX(w-1, 1);		break;
+				case TEST_CHECKER: v = ((x/7 + y/5) & 1) ? 250 : 5;	break;
+				default:	   v = MXGRAY/2 + rand()%9 - 4;		break;
+				}
+				*p++ = (uchar) v;
+			}
+		}
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// testSame:
+//
+// Return 1 if uchar images I1 and I2 have the same size, channels and
+// pixels.
+//
+bool
+testSame(const ImagePtr &I1, const ImagePtr &I2)
+{
+	int w = I1->width();
+	int h = I1->height();
+	if(w != I2->width() || h != I2->height() ||
+	   I1->maxChannel() != I2->maxChannel())
+		return 0;
+
+	for(int ch=0; ch<I1->maxChannel(); ch++) {
+		if(I1->channelType(ch) != UCHAR_TYPE ||
+		   I2->channelType(ch) != UCHAR_TYPE)
+			return 0;
+		if(memcmp((*I1)[ch]->buf(), (*I2)[ch]->buf(), (size_t) w*h))
+			return 0;
+	}
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// main:
+//
+// Run the tests named on the command line, or all of them. Exit status
+// is the number of failed tests, or 255 for an unknown test name.
+//
+int main(int argc, char **argv)
+{
+	for(int i=1; i<argc; i++) {
+		int t;
+		for(t=0; Tests[t].name && strcmp(Tests[t].name, argv[i]); t++);
+		if(!Tests[t].name) {
+			fprintf(stderr, "nailart-test: unknown test %s\n", argv[i]);
+			return 255;
+		}
+	}
+
+	int failed = 0;
+	for(int t=0; Tests[t].name; t++) {
+		bool run = (argc == 1);
+		for(int i=1; i<argc && !run; i++)
+			run = !strcmp(Tests[t].name, argv[i]);
+		if(!run) continue;
+
+		int failures = Tests[t].run();
+		printf("%-12s %s\n", Tests[t].name, failures ? "FAILED" : "ok");
+		if(failures) failed++;
+	}
+	return failed;
+}
@@ -0,0 +1,409 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// BitChannel.h - Bit-packed binary channel.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	BitChannel.h
+//! \brief	BitChannel class.
+//! \author	George Wolberg, 2015
+
+#ifndef BITCHANNEL_H
+#define BITCHANNEL_H
+
+#include <algorithm>
+#include <vector>
+#include "IPdefs.h"
+#include "IPsimd.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace IP {
+
+typedef unsigned long long BitWord;	// 64 pixels of a BitChannel row
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel class declaration
+//! \brief	Bit-packed binary channel.
+//! \details	One bit per pixel, 64 pixels per word. Pixel x of a row
+//!		is bit x%64 of word x/64 (least significant bit first).
+//!		Every row starts on a new word; bits past the width are
+//!		always 0, so counts need no masking. Takes 1/8 the memory
+//!		of a uchar channel. See IP_packBits() and IP_unpackBits()
+//!		for conversion to and from BW images.
+//
+class BitChannel {
+public:
+	// constructors
+	BitChannel();			// default constructor
+	BitChannel(int, int);		// all-zero channel of given size
+
+	// get methods
+	bool	 isNull	() const;	// 0x0 channel
+	int	 width	() const;	// channel width
+	int	 height	() const;	// channel height
+	int	 words	() const;	// words per row
+	size_t	 bytes	() const;	// bytes of bit storage
+	bool	 bit	(int, int) const;		// pixel value
+
+	// row access
+	const BitWord	*row(int) const;
+	      BitWord	*row(int);
+
+	// set methods
+	void	 resize	(int, int);	// resize and clear
+	void	 clear	();		// set all bits to 0
+	void	 setBit	(int, int, bool);
+	void	 swap	(BitChannel &);
+
+	// bit counts
+	int	 count	  () const;	// number of set bits
+	int	 countRow (int) const;	// number of set bits in row
+	static int popcount(BitWord);	// number of set bits in word
+	static int lowestBit(BitWord);	// index of lowest set bit (w != 0)
+
+private:
+	static int countWords(const BitWord *, size_t);
+#if defined(IP_POPCNT)
+	IP_TARGET_POPCNT
+	static int countWordsPOPCNT(const BitWord *, size_t);
+#endif
+
+	int			m_width, m_height;	// channel dimensions
+	int			m_words;		// words per row
+	std::vector<BitWord>	m_bits;			// m_height x m_words
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::BitChannel:
+//
+// Default constructor.
+//! \brief	Default constructor.
+//! \details	Empty 0x0 channel.
+//
+inline
+BitChannel::BitChannel()
+	: m_width (0),
+	  m_height(0),
+	  m_words (0)
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::BitChannel:
+//
+// Constructor. All bits are 0.
+//! \brief	Constructor.
+//! \param[in]	w,h - Channel width and height.
+//
+inline
+BitChannel::BitChannel(int w, int h)
+	: m_width (0),
+	  m_height(0),
+	  m_words (0)
+{
+	resize(w, h);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::isNull:
+//
+// Test if the channel has no pixels.
+//! \brief	Test if the channel has no pixels.
+//! \return	A boolean value.
+//
+inline bool
+BitChannel::isNull() const
+{
+	return (!m_width || !m_height);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::width:
+//
+// Channel width.
+//! \brief	Channel width.
+//
+inline int
+BitChannel::width() const
+{
+	return m_width;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::height:
+//
+// Channel height.
+//! \brief	Channel height.
+//
+inline int
+BitChannel::height() const
+{
+	return m_height;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::words:
+//
+// Number of words per row.
+//! \brief	Number of words per row.
+//
+inline int
+BitChannel::words() const
+{
+	return m_words;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::bytes:
+//
+// Number of bytes of bit storage.
+//! \brief	Number of bytes of bit storage.
+//
+inline size_t
+BitChannel::bytes() const
+{
+	return m_bits.size() * sizeof(BitWord);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::bit:
+//
+// Value of pixel (x,y).
+//! \brief	Value of pixel (\a x,\a y).
+//! \return	A boolean value.
+//
+inline bool
+BitChannel::bit(int x, int y) const
+{
+	return (row(y)[x >> 6] >> (x & 63)) & 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::row:
+//
+// Pointer to the words() words of row y.
+//! \brief	Pointer to row \a y.
+//
+inline const BitWord *
+BitChannel::row(int y) const
+{
+	return &m_bits[(size_t) y * m_words];
+}
+
+inline BitWord *
+BitChannel::row(int y)
+{
+	return &m_bits[(size_t) y * m_words];
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::resize:
+//
+// Resize channel to w x h and set all bits to 0.
+//! \brief	Resize channel and set all bits to 0.
+//! \param[in]	w,h - Channel width and height.
+//
+inline void
+BitChannel::resize(int w, int h)
+{
+	m_width  = MAX(w, 0);
+	m_height = MAX(h, 0);
+	m_words  = (m_width + 63) >> 6;
+	m_bits.assign((size_t) m_height * m_words, 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::clear:
+//
+// Set all bits to 0.
+//! \brief	Set all bits to 0.
+//
+inline void
+BitChannel::clear()
+{
+	std::fill(m_bits.begin(), m_bits.end(), 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::setBit:
+//
+// Set pixel (x,y) to v.
+//! \brief	Set pixel (\a x,\a y) to \a v.
+//
+inline void
+BitChannel::setBit(int x, int y, bool v)
+{
+	BitWord &w = row(y)[x >> 6];
+	BitWord  m = (BitWord) 1 << (x & 63);
+	if(v) w |=  m;
+	else  w &= ~m;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::swap:
+//
+// Exchange contents with channel c without copying bits.
+//! \brief	Exchange contents with \a c.
+//
+inline void
+BitChannel::swap(BitChannel &c)
+{
+	std::swap(m_width,  c.m_width);
+	std::swap(m_height, c.m_height);
+	std::swap(m_words,  c.m_words);
+	m_bits.swap(c.m_bits);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::count:
+//
+// Return number of set bits in the channel.
+//! \brief	Number of set bits.
+//
+inline int
+BitChannel::count() const
+{
+	return m_bits.empty() ? 0 : countWords(&m_bits[0], m_bits.size());
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::countRow:
+//
+// Return number of set bits in row y.
+//! \brief	Number of set bits in row \a y.
+//
+inline int
+BitChannel::countRow(int y) const
+{
+	return countWords(row(y), m_words);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::countWords:
+//
+// Return number of set bits in the n words at p. Uses the POPCNT
+// instruction if the CPU has it (IP_hasPOPCNT()), and popcount()
+// otherwise.
+//
+inline int
+BitChannel::countWords(const BitWord *p, size_t n)
+{
+#if defined(IP_POPCNT)
+	if(IP_hasPOPCNT()) return countWordsPOPCNT(p, n);
+#endif
+	int c = 0;
+	for(size_t i=0; i<n; ++i)
+		c += popcount(p[i]);
+	return c;
+}
+
+
+
+#if defined(IP_POPCNT)
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::countWordsPOPCNT:
+//
+// countWords() with the POPCNT instruction. Run only if IP_hasPOPCNT().
+//
+IP_TARGET_POPCNT inline int
+BitChannel::countWordsPOPCNT(const BitWord *p, size_t n)
+{
+	int c = 0;
+	for(size_t i=0; i<n; ++i) {
+#if defined(__GNUC__)
+		c += __builtin_popcountll(p[i]);
+#else
+		c += (int) __popcnt64(p[i]);
+#endif
+	}
+	return c;
+}
+#endif
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::popcount:
+//
+// Return number of set bits in w. Runs on any CPU; count() and
+// countRow() switch to the POPCNT instruction at runtime instead.
+//! \brief	Number of set bits in \a w.
+//
+inline int
+BitChannel::popcount(BitWord w)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(w);	// POPCNT only if the target has it
+#else
+	// SWAR count: MSVC's __popcnt64 would fault on CPUs without POPCNT
+	w = w - ((w >> 1) & 0x5555555555555555ULL);
+	w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+	w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int) ((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BitChannel::lowestBit:
+//
+// Return index of the lowest set bit of w, which must be nonzero.
+// Used with w &= w-1 to visit the set bits of a word in order.
+//! \brief	Index of lowest set bit of \a w (\a w != 0).
+//
+inline int
+BitChannel::lowestBit(BitWord w)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(w);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long i;
+	_BitScanForward64(&i, w);
+	return (int) i;
+#else
+	int i = 0;
+	while(!(w & 1)) { w >>= 1; ++i; }
+	return i;
+#endif
+}
+
+}	// namespace IP
+
+#endif	// BITCHANNEL_H
@@ -15,6 +15,7 @@
 #define CHANNEL_H
 
 #include "IPdefs.h"
+#include "ChannelPool.h"
 
 namespace IP {
 
@@ -22,7 +23,10 @@ namespace IP {
 // Channel class declaration
 //! \brief      Channel class.
 //! \details	The Channel class handles image channel data of various
-//!		types.
+//!		types. Buffers come from ChannelPool, which recycles the
+//!		buffers of freed channels for channels of similar size.
+//!		The layout is that of the prebuilt library: a single
+//!		buffer pointer.
 //
 class Channel {
 public:
@@ -69,12 +73,13 @@ Channel::Channel()
 //
 // Size constructor. Allocate specified number of bytes to channel.
 //! \brief	Size constructor.
-//! \details	Allocate specified number of bytes to channel.
+//! \details	Allocate specified number of bytes to channel from the
+//!		channel pool.
 //
 inline
 Channel::Channel(int size)
 {
-	m_buf = new uchar[size];
+	m_buf = ChannelPool::instance().alloc(size);
 }
 
 
@@ -82,14 +87,14 @@ Channel::Channel(int size)
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Channel::~Channel:
 //
-// Destructor function. Free channel memory and set channel pointer to null.
+// Destructor function. Release channel memory.
 //! \brief	Destructor.
-//! \details	Free channel memory and set channel pointer to null.
+//! \details	Release channel memory (see free()).
 //
 inline
 Channel::~Channel()
 {
-	if (m_buf) delete [] (uchar *) m_buf;
+	free();
 }
 
 
@@ -131,12 +136,14 @@ Channel::buf()
 //
 // Resize channel buffer to have size bytes.
 //! \brief	Resize channel buffer.
-//! \details	Resize channel buffer to \a size bytes. Reset channel pointer.
+//! \details	Release the current buffer and take one of \a size bytes
+//!		from the channel pool. Contents are not preserved.
 //
 inline void
 Channel::resize(int size)
 {
-	m_buf = new uchar[size];
+	free();
+	m_buf = ChannelPool::instance().alloc(size);
 }
 
 
@@ -146,12 +153,13 @@ Channel::resize(int size)
 //
 // Free channel buffer.
 //! \brief	Free channel buffer.
-//! \details	Free channel memory and reset channel pointer to null.
+//! \details	Return channel memory to the channel pool and reset
+//!		channel pointer to null.
 //
 inline void
 Channel::free() {
 	if(m_buf) {
-		delete [] (uchar*) m_buf;
+		ChannelPool::instance().release(m_buf);
 		m_buf = 0;
 	}
 }
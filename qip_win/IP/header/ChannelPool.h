@@ -0,0 +1,438 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// ChannelPool.h - Size-classed pool of channel buffers.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	ChannelPool.h
+//! \brief	Size-classed pool of channel buffers.
+//! \author	George Wolberg, 2015
+
+#ifndef CHANNELPOOL_H
+#define CHANNELPOOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "IPdefs.h"
+
+namespace IP {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool class declaration
+//! \brief	Size-classed pool of channel buffers.
+//! \details	Channel buffers are rounded up to a size class and
+//!		returned to the pool when their channel is freed, so
+//!		that images of the same size allocated again (e.g., the
+//!		intermediate images of each preview run) reuse memory that
+//!		is already mapped. Size classes are 4 steps per power of
+//!		two, wasting at most 25%. Buffers below 4 KB bypass the
+//!		pool. The pool keeps at most maxPerClass buffers of each
+//!		class and maxBytes in total; buffers beyond that are freed.
+//!		Buffers are allocated with new uchar[] and freed with
+//!		delete[], as the prebuilt library does.
+//!
+//!		Ownership is explicit: the pool registers each buffer it
+//!		hands out, with its capacity, and takes back only
+//!		registered buffers passed to release() (by Channel::free()).
+//!		Any other buffer, e.g. one the library allocated, is freed.
+//!		The library frees channel buffers only in the Channel and
+//!		Image members it shares with these headers, which it calls
+//!		out of line, so pool buffers come back through release().
+//!
+//!		The registry is split into shards by buffer address and the
+//!		free lists by size class, each with its own lock; counters
+//!		are atomic. No call takes a process-wide lock, and buffers
+//!		that bypass the pool take none on allocation.
+//!		All methods are thread-safe.
+//
+class ChannelPool {
+public:
+	//! Pool statistics.
+	struct Stats {
+		long long hits;		// allocations served from the pool
+		long long misses;	// allocations that went to the heap
+		long long returns;	// buffers taken back into the pool
+		long long drops;	// buffers freed due to retention limits
+		size_t	  bytes;	// bytes currently held by the pool
+		int	  buffers;	// buffers currently held by the pool
+	};
+
+	static ChannelPool &instance();
+
+	void	*alloc	 (int);
+	void	 release (void *);
+	void	 setLimits(size_t, int);
+	void	 trim	 ();
+	Stats	 stats	 () const;
+	void	 resetStats();
+
+private:
+	enum {
+		NUMCLASSES = 4 * 30,	// 4 classes per power of two
+		NUMSHARDS  = 16,	// registry shards
+		MINSIZE    = 4096,	// smaller buffers bypass the pool
+		MAXSIZE    = 1 << 30	// larger  buffers bypass the pool
+	};
+
+	//! Registry of buffers handed out, with their capacity (bytes).
+	typedef std::unordered_map<const void *, int> BufferMap;
+
+	//! Registry shard.
+	struct Shard {
+		std::mutex	mutex;
+		BufferMap	bufs;
+	};
+
+	//! Free list of a size class.
+	struct FreeList {
+		std::mutex	    mutex;
+		std::vector<void *> bufs;
+	};
+
+	ChannelPool();
+	ChannelPool(const ChannelPool &);
+	ChannelPool &operator=(const ChannelPool &);
+
+	static int   sizeClass	  (int, int &);
+	static int   classCapacity(int);
+	static void *allocBuffer  (int);
+	static void  freeBuffer	  (void *);
+	Shard	    &shard	  (const void *) const;
+	bool	     keep	  (int, void *);
+
+	mutable Shard		 m_shards[NUMSHARDS];	// buffers handed out
+	FreeList		 m_free[NUMCLASSES];	// free buffers per class
+	std::atomic<size_t>	 m_maxBytes;		// retention limit (bytes)
+	std::atomic<int>	 m_maxPerClass;		// retention limit per class
+	std::atomic<long long>	 m_hits, m_misses, m_returns, m_drops;
+	std::atomic<size_t>	 m_bytes;		// bytes held
+	std::atomic<int>	 m_buffers;		// buffers held
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::ChannelPool:
+//
+// Constructor. Default limits keep up to 256 MB in at most 8 buffers
+// per size class.
+//
+inline
+ChannelPool::ChannelPool()
+	: m_maxBytes   (256 << 20),
+	  m_maxPerClass(8),
+	  m_hits       (0),
+	  m_misses     (0),
+	  m_returns    (0),
+	  m_drops      (0),
+	  m_bytes      (0),
+	  m_buffers    (0)
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::instance:
+//
+// Return the process-wide pool. It is never destroyed, so that static
+// images may still free their channels during program exit.
+//! \brief	Process-wide channel pool.
+//
+inline ChannelPool &
+ChannelPool::instance()
+{
+	static ChannelPool *pool = new ChannelPool;
+	return *pool;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::sizeClass:
+//
+// Return size class of a buffer of size bytes and set cap to the
+// capacity of that class. Return -1 for buffers that bypass the pool;
+// their capacity is size.
+//
+inline int
+ChannelPool::sizeClass(int size, int &cap)
+{
+	cap = size;
+	if(size < MINSIZE || size > MAXSIZE) return -1;
+
+	// size lies in (2^k, 2^(k+1)]; split that range into 4 classes
+	int k = 0;
+	while((2 << k) < size) k++;
+	int step = (1 << k) / 4;
+	int sub  = (size - (1 << k) + step-1) / step;	// 1..4
+	int cls  = 4*k + sub - 1;
+
+	cap = classCapacity(cls);
+	return cls;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::classCapacity:
+//
+// Return capacity (bytes) of size class cls.
+//
+inline int
+ChannelPool::classCapacity(int cls)
+{
+	int k = cls / 4;
+	return (1 << k) + (cls%4 + 1) * ((1 << k) / 4);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::allocBuffer:
+//
+// Allocate size bytes from the heap, as Channel::resize() does in the
+// prebuilt library.
+//
+inline void *
+ChannelPool::allocBuffer(int size)
+{
+	return new uchar[size];
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::freeBuffer:
+//
+// Free buffer from allocBuffer() or from the prebuilt library.
+//
+inline void
+ChannelPool::freeBuffer(void *buf)
+{
+	delete [] (uchar *) buf;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::shard:
+//
+// Return registry shard of buffer buf.
+//
+inline ChannelPool::Shard &
+ChannelPool::shard(const void *buf) const
+{
+	size_t a = (size_t) buf >> 12;		// buffers are >= 4 KB apart
+	return m_shards[(a ^ (a >> 4)) % NUMSHARDS];
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::keep:
+//
+// Put buffer buf of size class cls on its free list, unless retention
+// limits are reached. Return true if kept.
+//
+inline bool
+ChannelPool::keep(int cls, void *buf)
+{
+	int cap = classCapacity(cls);
+	FreeList &list = m_free[cls];
+	std::lock_guard<std::mutex> lock(list.mutex);
+	if((int) list.bufs.size() >= m_maxPerClass ||
+	   m_bytes + cap > m_maxBytes)
+		return false;
+	list.bufs.push_back(buf);
+	m_bytes += cap;
+	m_buffers++;
+	return true;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::alloc:
+//
+// Return a buffer of at least size bytes. Buffers of a size class are
+// registered as the pool's; pass them to release() when no longer
+// needed. Smaller and larger buffers come straight from the heap.
+//! \brief	Allocate channel buffer.
+//! \param[in]	size - Number of bytes.
+//! \return	Buffer.
+//
+inline void *
+ChannelPool::alloc(int size)
+{
+	int cap;
+	int cls = sizeClass(size, cap);
+	if(cls < 0) return allocBuffer(size);
+
+	void *buf = 0;
+	{
+		FreeList &list = m_free[cls];
+		std::lock_guard<std::mutex> lock(list.mutex);
+		if(!list.bufs.empty()) {
+			buf = list.bufs.back();
+			list.bufs.pop_back();
+			m_bytes -= cap;
+			m_buffers--;
+		}
+	}
+	if(buf) m_hits++;
+	else {
+		m_misses++;
+		buf = allocBuffer(cap);
+	}
+
+	Shard &sh = shard(buf);
+	std::lock_guard<std::mutex> lock(sh.mutex);
+	sh.bufs[buf] = cap;
+	return buf;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::release:
+//
+// Take back buffer buf if alloc() registered it, unless retention
+// limits are reached. Any other buffer is freed.
+//! \brief	Return channel buffer to the pool.
+//! \param[in]	buf - Buffer from alloc() or the library (may be NULL).
+//
+inline void
+ChannelPool::release(void *buf)
+{
+	if(!buf) return;
+
+	int cap = 0;
+	{
+		Shard &sh = shard(buf);
+		std::lock_guard<std::mutex> lock(sh.mutex);
+		BufferMap::iterator it = sh.bufs.find(buf);
+		if(it != sh.bufs.end()) {
+			cap = it->second;
+			sh.bufs.erase(it);
+		}
+	}
+
+	if(cap) {
+		int c;
+		int cls = sizeClass(cap, c);
+		if(keep(cls, buf)) {
+			m_returns++;
+			return;
+		}
+		m_drops++;
+	}
+	freeBuffer(buf);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::setLimits:
+//
+// Set retention limits: at most maxBytes in total and at most
+// maxPerClass buffers per size class. Pass 0 to disable pooling.
+// Buffers already pooled beyond the new limits are freed.
+//! \brief	Set retention limits.
+//! \param[in]	maxBytes    - Maximum bytes held by the pool.
+//! \param[in]	maxPerClass - Maximum buffers held per size class.
+//
+inline void
+ChannelPool::setLimits(size_t maxBytes, int maxPerClass)
+{
+	m_maxBytes    = maxBytes;
+	m_maxPerClass = maxPerClass;
+
+	// free largest classes first until within limits
+	for(int cls=NUMCLASSES-1; cls>=0; cls--) {
+		FreeList &list = m_free[cls];
+		int cap = classCapacity(cls);
+		std::lock_guard<std::mutex> lock(list.mutex);
+		while(!list.bufs.empty() &&
+		      ((int) list.bufs.size() > maxPerClass ||
+		       m_bytes > maxBytes)) {
+			freeBuffer(list.bufs.back());
+			list.bufs.pop_back();
+			m_drops++;
+			m_bytes -= cap;
+			m_buffers--;
+		}
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::trim:
+//
+// Free all pooled buffers.
+//! \brief	Free all pooled buffers.
+//
+inline void
+ChannelPool::trim()
+{
+	for(int cls=0; cls<NUMCLASSES; cls++) {
+		FreeList &list = m_free[cls];
+		int cap = classCapacity(cls);
+		std::lock_guard<std::mutex> lock(list.mutex);
+		for(size_t i=0; i<list.bufs.size(); i++) {
+			freeBuffer(list.bufs[i]);
+			m_bytes -= cap;
+			m_buffers--;
+		}
+		list.bufs.clear();
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::stats:
+//
+// Return pool statistics. Counters are read one at a time, so they
+// need not agree with each other while other threads use the pool.
+//! \brief	Pool statistics.
+//
+inline ChannelPool::Stats
+ChannelPool::stats() const
+{
+	Stats st;
+	st.hits	   = m_hits;
+	st.misses  = m_misses;
+	st.returns = m_returns;
+	st.drops   = m_drops;
+	st.bytes   = m_bytes;
+	st.buffers = m_buffers;
+	return st;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPool::resetStats:
+//
+// Reset hit, miss, return and drop counters.
+//! \brief	Reset counters.
+//
+inline void
+ChannelPool::resetStats()
+{
+	m_hits	  = 0;
+	m_misses  = 0;
+	m_returns = 0;
+	m_drops	  = 0;
+}
+
+}	// namespace IP
+
+#endif	// CHANNELPOOL_H
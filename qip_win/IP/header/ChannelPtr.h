@@ -30,6 +30,7 @@ public:
 	ChannelPtr();				// default constructor
 	ChannelPtr(const ChannelPtr &);		// copy constructor
 	ChannelPtr(Channel *c);			// construct from channel ptr
+	explicit ChannelPtr(T *p);		// construct from buffer ptr
 
 	// destructor
 	~ChannelPtr();
@@ -57,6 +57,21 @@ ChannelPtr<T>::ChannelPtr(Channel *c)
 
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ChannelPtr::ChannelPtr:
+//
+// Constructor (from buffer pointer).
+//! \brief	Constructor (from buffer pointer).
+//! \details	Point at buffer \a p, e.g., scratch memory not owned by
+//!		a Channel. The buffer must outlive the ChannelPtr.
+//
+template<class T>
+ChannelPtr<T>::ChannelPtr(T *p)
+	: m_buf(p)
+{}
+
+
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // ChannelPtr::~ChannelPtr:
 //
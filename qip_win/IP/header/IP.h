@@ -27,6 +27,11 @@
 #include "ChannelPtr.h"
 #include "Image.h"
 #include "ImagePtr.h"
+#include "ImageView.h"
+#include "BitChannel.h"
+#include "IPparallel.h"
+#include "IPscratch.h"
+#include "IPsimd.h"
 #include <QtWidgets>
 
 namespace IP {
@@ -159,6 +164,9 @@ extern void	IP_halftone	  (ImagePtr, int,int,double,ImagePtr);
 extern void	IP_ditherDiffuse  (ImagePtr, int, double,   ImagePtr);
 extern void	IP_ditherED	  (ImagePtr,      double,   ImagePtr);
 
+//		IPdiffuse.tpp	- multithreaded error diffusion
+#include "IPdiffuse.tpp"
+
 //		IPfft.cpp	- 1D and 2D Fourier transforms
 extern void	IP_fft2D	(ImagePtr, int, ImagePtr);
 extern void	IP_fft1D	(ImagePtr, int, ImagePtr);
@@ -178,6 +186,15 @@ extern void	IP_sobel	(ImagePtr, ImagePtr);
 extern void	IP_laplacian	(ImagePtr, ImagePtr);
 extern void	IP_laplacianThresh(ImagePtr, double*, ImagePtr);
 
+//		IPbox.tpp	- integer running-sum box filter over lanes
+#include "IPbox.tpp"
+
+//		IPblurMT.tpp	- multithreaded, cache-blocked blur and sharpen
+#include "IPblurMT.tpp"
+
+//		IPgauss.tpp	- recursive (IIR) Gaussian blur
+#include "IPgauss.tpp"
+
 //		IPfiltpt.cpp	- Point Ops
 extern void	IP_threshold	(ImagePtr, double, double, double, double, double, ImagePtr);
 extern void	IP_thresholdOtsu(ImagePtr, int*, ImagePtr);
@@ -204,6 +221,9 @@ extern void	IP_skew1D	(ChannelPtr<uchar>, int, int, double, int,
 extern void	IP_fskew1D	(ChannelPtr<float>, int, int, double, int,
 				 ChannelPtr<float>);
 
+//		IParea.tpp	- area resampling with summed-area table
+#include "IParea.tpp"
+
 //		IPhisto.cpp	- histogram evaluation, manipulation, display
 extern void	IP_histogram	    (ImagePtr, int, int*, int, double&,double&);
 extern void	IP_histogramEqualize(ImagePtr, ImagePtr);
@@ -252,13 +272,13 @@ extern int	IP_mipmap	(Image, Image&);
 //		IPmmch.cpp	- channel memory management
 #include "IPmmch.tpp"
 template<class T>
-	bool	IP_getChannel 	  (ImagePtr, int, ChannelPtr<T>&, int &);
+	bool	IP_getChannel 	  (const ImagePtr&, int, ChannelPtr<T>&, int &);
 template<class T1, class T2>
 	void	IP_copyFromRow	  (ChannelPtr<T1>, int, int, ChannelPtr<T2>);
 template<class T>
-	void	IP_copyFromRow	  (ImagePtr, int, int, ChannelPtr<T>);
+	void	IP_copyFromRow	  (const ImagePtr&, int, int, ChannelPtr<T>);
 template<class T>
-	void    IP_copyToRow	  (ChannelPtr<T>, ImagePtr , int, int);
+	void    IP_copyToRow	  (ChannelPtr<T>, const ImagePtr&, int, int);
 template<class T1, class T2>
 	void	IP_copyToRow	  (ChannelPtr<T1>, ChannelPtr<T2>, int, int);
 
@@ -281,6 +301,27 @@ extern void	IP_copyHeader	(ImagePtr, int, ImagePtr);
 extern void	IP_copyHeader2	(ImagePtr, ImagePtr, int, ImagePtr);
 extern void	IP_copyImageBuffer(ImagePtr, ImagePtr);
 
+//		IPshare.tpp	- input images of in-place filters
+#include "IPshare.tpp"
+
+//		IPview.tpp	- image views: copy, tiling, blur
+#include "IPview.tpp"
+
+//		IPbits.tpp	- bit-packed channels: pack, unpack, QImage
+#include "IPbits.tpp"
+
+//		IPtone.tpp	- tone curve lookup tables
+#include "IPtone.tpp"
+
+//		IPpoint.tpp	- point operations on uchar images via lookup tables
+#include "IPpoint.tpp"
+
+//		IPmedian.tpp	- constant-time median filter
+#include "IPmedian.tpp"
+
+//		IPbilateral.tpp	- edge-preserving bilateral blur, exact and grid
+#include "IPbilateral.tpp"
+
 //	IPmorph.cpp
 extern void	IP_shrink	(ImagePtr, int, ImagePtr);
 extern void	IP_dilate	(ImagePtr, int, ImagePtr);
@@ -0,0 +1,391 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IParea.tpp - Area-averaging resampler based on a summed-area table.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IParea.tpp
+//! \brief	Area-averaging resampler based on a summed-area table.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_allocImageInI(ImagePtr, int, int, int*);
+
+//! \addtogroup geo
+//@{
+
+// ----------------------------------------------------------------------
+// span of one output sample along one axis: the output sample covers
+// input interval [x0, x1). Its sum is the weighted sum of the table
+// differences S(idx[k]) - S(base), with weights already divided by the
+// span length x1-x0
+//
+struct AreaSpan {
+	int	base;		// floor(x0)
+	int	idx[3];		// table indices
+	double	wt [3];		// weights
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_areaSpans:
+//
+// Compute spans of nlen output samples covering len input samples.
+// The table is bilinear between its integer entries, so the sum over
+// [x0, x1) with x0 = i0+a0 and x1 = i1+a1 is
+//	(1-a1)(S(i1)-S(i0)) + a1(S(i1+1)-S(i0)) - a0(S(i0+1)-S(i0)).
+//! \brief	Area spans of nlen output samples over len input samples.
+//! \param[in]	len  - Number of input samples.
+//! \param[in]	nlen - Number of output samples.
+//! \param[out]	sp   - Spans.
+//
+inline void
+IP_areaSpans(int len, int nlen, std::vector<AreaSpan> &sp)
+{
+	double scale = (double) len / nlen;
+	sp.resize(nlen);
+	for(int u=0; u<nlen; ++u) {
+		double x0 = u * scale;
+		double x1 = MIN((u+1) * scale, (double) len);
+		int i0 = MIN((int) x0, len-1);
+		int i1 = MIN((int) x1, len-1);
+		double a0 = x0 - i0;
+		double a1 = x1 - i1;
+		double n  = 1. / (x1 - x0);
+
+		AreaSpan &s = sp[u];
+		s.base	 = i0;
+		s.idx[0] = i1;	 s.wt[0] =  (1-a1) * n;
+		s.idx[1] = i1+1; s.wt[1] =     a1  * n;
+		s.idx[2] = i0+1; s.wt[2] =    -a0  * n;
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_areaFits:
+//
+// Return 1 if every rectangle summed to resize sw x sh source pixels to
+// w x h spans fewer than 2^24 source pixels. Its sum is then below 2^32,
+// so 32-bit sums that wrap around (see AreaTable) are still exact.
+// Heavy minification, e.g., of a 50 MP image to a width or height of a
+// few pixels, exceeds this; such resizes must be done otherwise.
+//! \brief	Check that an area resize fits 32-bit sums.
+//! \param[in]	sw, sh - Source width and height.
+//! \param[in]	w, h   - Output width and height.
+//! \return	1 if the resize fits, 0 otherwise.
+//
+inline bool
+IP_areaFits(int sw, int sh, int w, int h)
+{
+	if(w <= 0 || h <= 0) return 0;
+
+	// widest span of each axis: rectangles reach columns [base, idx[1])
+	std::vector<AreaSpan> sp;
+	size_t n[2] = { 0, 0 };
+	for(int a=0; a<2; ++a) {
+		IP_areaSpans(a ? sh : sw, a ? h : w, sp);
+		for(int u=0; u<(int) sp.size(); ++u)
+			n[a] = MAX(n[a], (size_t) (sp[u].idx[1] - sp[u].base));
+	}
+	return n[0] * n[1] < ((size_t) 1 << 24);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_areaPixel:
+//
+// Return the output pixel of spans sx and sy: the weighted sum of the
+// rectangle sums rect(i, j) over source columns [sx.base, sx.idx[i]) and
+// rows [sy.base, sy.idx[j]), rounded, clipped, and passed through lut if
+// it is given. AreaTable and AreaRows both compute pixels here, so they
+// produce the same output.
+//! \brief	Output pixel of an area span pair.
+//! \param[in]	sx, sy - Column and row spans.
+//! \param[in]	rect   - Rectangle sum of taps i and j.
+//! \param[in]	lut    - Optional lookup table of MXGRAY entries.
+//! \return	Output pixel.
+//
+template<class Rect>
+inline uchar
+IP_areaPixel(const AreaSpan &sx, const AreaSpan &sy, const Rect &rect,
+	     const uchar *lut)
+{
+	double v = 0;
+	for(int j=0; j<3; ++j) {
+		if(!sy.wt[j]) continue;
+		double row = 0;
+		for(int i=0; i<3; ++i) {
+			if(!sx.wt[i]) continue;
+			row += sx.wt[i] * rect(i, j);
+		}
+		v += sy.wt[j] * row;
+	}
+	int g = CLIP(ROUND(v), 0, MaxGray);
+	return lut ? lut[g] : (uchar) g;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+///
+/// \class AreaTable
+/// \brief Summed-area table of a BW image for fast area resampling
+///
+/// build() sums the source once in O(source pixels); resize() then
+/// produces any smaller image by exact box-area averaging in
+/// O(target pixels), independent of the source size.
+/// Entries are 32-bit and are allowed to wrap around: every value that
+/// resize() reads is the difference of table entries spanning less than
+/// 2^24 source pixels, which is exact in modular arithmetic. resize()
+/// fails for sizes where a span would be larger (see IP_areaFits()).
+/// The table takes 4 bytes per source pixel.
+///
+//////////////////////////////////////////////////////////////////////////
+
+class AreaTable {
+public:
+	AreaTable() : m_width(0), m_height(0) {}
+
+	bool	build (const ImagePtr &);
+	void	clear ();
+	bool	resize(int, int, const ImagePtr &, const uchar *lut = 0) const;
+
+	bool	isNull() const { return m_sum.empty(); }
+	int	width () const { return m_width;  }
+	int	height() const { return m_height; }
+
+private:
+	unsigned int rect(int, int, int, int) const;
+
+	int			  m_width;	// source width
+	int			  m_height;	// source height
+	std::vector<unsigned int> m_sum;	// (width+1) x (height+1) table
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AreaTable::build:
+//
+// Build summed-area table of channel 0 of I1: entry (x, y) is the sum
+// of all pixels above and to the left of it. Row 0 and column 0 are 0.
+// Return 1 for success, 0 if I1 is empty or channel 0 is not uchar.
+//! \brief	Build summed-area table of channel 0 of \a I1.
+//! \param[in]	I1 - Input image (uchar channel 0).
+//! \return	1 for success, 0 for failure.
+//
+inline bool
+AreaTable::build(const ImagePtr &I1)
+{
+	clear();
+	if(I1.isNull() || I1->channelType(0) != UCHAR_TYPE) return 0;
+
+	int w = I1->width();
+	int h = I1->height();
+	int tw = w + 1;
+	m_sum.assign((size_t) tw * (h+1), 0);
+
+	ChannelPtr<uchar> p1 = (*I1)[0];
+	const uchar *src = p1.buf();
+	for(int y=0; y<h; ++y) {
+		const uchar	   *in	= src + (size_t) y*w;
+		const unsigned int *up	= &m_sum[(size_t)  y   *tw];
+		unsigned int	   *out = &m_sum[(size_t) (y+1)*tw];
+		unsigned int	    row = 0;
+		for(int x=0; x<w; ++x) {
+			row += in[x];
+			out[x+1] = up[x+1] + row;
+		}
+	}
+	m_width  = w;
+	m_height = h;
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AreaTable::clear:
+//
+// Free the table.
+//! \brief	Free the table.
+//
+inline void
+AreaTable::clear()
+{
+	std::vector<unsigned int>().swap(m_sum);
+	m_width = m_height = 0;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AreaTable::rect:
+//
+// Return sum of source pixels in columns [x0, x1) and rows [y0, y1).
+// Wrap-around in the table cancels out as long as the sum fits 32 bits.
+//
+inline unsigned int
+AreaTable::rect(int x0, int y0, int x1, int y1) const
+{
+	size_t tw = m_width + 1;
+	const unsigned int *r0 = &m_sum[y0 * tw];
+	const unsigned int *r1 = &m_sum[y1 * tw];
+	return r1[x1] - r1[x0] - r0[x1] + r0[x0];
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AreaTable::resize:
+//
+// I2 <- Source resized to w x h by averaging the source area that each
+// output pixel covers. Meant for minification; magnifying an axis
+// replicates pixels along it. If lut is given, each output pixel is
+// passed through it as it is written (see IP_toneLut()), so a tone
+// curve costs no extra pass over the output.
+// Return 1 for success, 0 if the table is empty, w or h is not positive,
+// or the output pixels span too many source pixels for 32-bit sums
+// (see IP_areaFits()); callers then resize by other means.
+//! \brief	Resize source to \a w x \a h by exact area averaging.
+//! \param[in]	w   - Output width.
+//! \param[in]	h   - Output height.
+//! \param[out]	I2  - Output BW image.
+//! \param[in]	lut - Optional lookup table of MXGRAY entries.
+//! \return	1 for success, 0 for failure.
+//
+inline bool
+AreaTable::resize(int w, int h, const ImagePtr &I2, const uchar *lut) const
+{
+	if(isNull() || !IP_areaFits(m_width, m_height, w, h)) return 0;
+
+	std::vector<AreaSpan> xs, ys;
+	IP_areaSpans(m_width,  w, xs);
+	IP_areaSpans(m_height, h, ys);
+
+	IP_allocImageInI(I2, w, h, BW_TYPE);
+	ChannelPtr<uchar> p2 = (*I2)[0];
+	uchar *out = p2.buf();
+	for(int y=0; y<h; ++y) {
+		const AreaSpan &sy = ys[y];
+		for(int x=0; x<w; ++x) {
+			const AreaSpan &sx = xs[x];
+			auto sum = [&](int i, int j) {
+				return rect(sx.base, sy.base, sx.idx[i], sy.idx[j]);
+			};
+			*out++ = IP_areaPixel(sx, sy, sum, lut);
+		}
+	}
+	return 1;
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////
+///
+/// \class AreaRows
+/// \brief Row-at-a-time area resampler
+///
+/// Produces the rows of AreaTable::resize() one at a time, top to
+/// bottom, without a summed-area table. For each output row the source
+/// rows it covers are summed into three prefix-sum rows, one per row
+/// tap, which take the place of the table rows. Sums are 32-bit and
+/// wrap around as in AreaTable, and pixels are computed by
+/// IP_areaPixel(), so the output is that of AreaTable::resize().
+/// Like it, AreaRows needs sizes for which IP_areaFits() holds.
+/// Working memory is four rows of source width + 1 entries.
+///
+//////////////////////////////////////////////////////////////////////////
+
+class AreaRows {
+public:
+	AreaRows(const uchar *src, int sw, int sh, int w, int h);
+
+	void	next(uchar *out, const uchar *lut = 0);	// resize next row
+
+private:
+	const uchar	*m_src;			// source pixels
+	int		 m_sw, m_sh;		// source size
+	int		 m_w;			// output width
+	int		 m_y;			// index of next row
+	std::vector<AreaSpan>	  m_xs, m_ys;	// column and row spans
+	std::vector<unsigned int> m_row;	// prefix sums of a source row
+	std::vector<unsigned int> m_sum[3];	// prefix sums of row taps
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AreaRows::AreaRows:
+//
+// Constructor for resizing the sw x sh uchar source src to w x h.
+//! \brief	Constructor.
+//! \param[in]	src    - Source pixels (sw*sh).
+//! \param[in]	sw, sh - Source width and height.
+//! \param[in]	w, h   - Output width and height.
+//
+inline
+AreaRows::AreaRows(const uchar *src, int sw, int sh, int w, int h)
+	: m_src(src),
+	  m_sw (sw),
+	  m_sh (sh),
+	  m_w  (w),
+	  m_y  (0)
+{
+	IP_areaSpans(sw, w, m_xs);
+	IP_areaSpans(sh, h, m_ys);
+	m_row.assign(sw+1, 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// AreaRows::next:
+//
+// Resize the next output row into out. If lut is given, each output
+// pixel is passed through it as it is written.
+//! \brief	Resize the next row.
+//! \param[out]	out - Output row (w pixels).
+//! \param[in]	lut - Optional lookup table of MXGRAY entries.
+//
+inline void
+AreaRows::next(uchar *out, const uchar *lut)
+{
+	const AreaSpan &sy = m_ys[m_y++];
+
+	// m_sum[j] <- prefix sums of source rows [sy.base, sy.idx[j])
+	for(int j=0; j<3; ++j)
+		m_sum[j].assign(m_sw+1, 0);
+	for(int r=sy.base; r<sy.idx[1]; ++r) {
+		const uchar *in = m_src + (size_t) r*m_sw;
+		unsigned int sum = 0;
+		for(int x=0; x<m_sw; ++x) {
+			sum += in[x];
+			m_row[x+1] = sum;
+		}
+		for(int j=0; j<3; ++j) {
+			if(r >= sy.idx[j]) continue;
+			unsigned int *s = &m_sum[j][0];
+			for(int x=1; x<=m_sw; ++x) s[x] += m_row[x];
+		}
+	}
+
+	for(int x=0; x<m_w; ++x) {
+		const AreaSpan &sx = m_xs[x];
+		auto sum = [&](int i, int j) {
+			const unsigned int *s = &m_sum[j][0];
+			return s[sx.idx[i]] - s[sx.base];
+		};
+		out[x] = IP_areaPixel(sx, sy, sum, lut);
+	}
+}
+
+//@}
@@ -0,0 +1,289 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPbilateral.tpp - Edge-preserving bilateral blur, exact and grid.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPbilateral.tpp
+//! \brief	Edge-preserving bilateral blur, exact and grid.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+//! \addtogroup filtnbr
+//@{
+
+// ----------------------------------------------------------------------
+// rows per work item of the exact filter and of grid slicing
+//
+enum { BILATERAL_BAND = 16 };
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_bilateralCheck:
+//
+// Return 1 if I1 has only uchar channels and the sigmas are positive,
+// otherwise report the problem for function fn and return 0.
+//
+inline int
+IP_bilateralCheck(const char *fn, const ImagePtr &I1, double sigmaS,
+		  double sigmaR)
+{
+	if(I1.isNull()) return 0;
+	if(sigmaS <= 0 || sigmaR <= 0) {
+		fprintf(stderr, "%s: sigmas must be positive (%f,%f)\n",
+			fn, sigmaS, sigmaR);
+		return 0;
+	}
+	for(int ch=0; ch<I1->maxChannel(); ch++) {
+		if(I1->channelType(ch) != UCHAR_TYPE) {
+			fprintf(stderr, "%s: channel %d is not uchar\n", fn, ch);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurBilateral:
+//
+// I2 <- Bilateral filter of I1: every pixel becomes the mean of its
+// neighbors weighted by a Gaussian of standard deviation sigmaS in
+// distance and one of standard deviation sigmaR in gray level, so that
+// noise and texture are smoothed while edges with a contrast well above
+// sigmaR are kept. The window spans 3*sigmaS on each side and is cut
+// off at the image border. This is the exact filter, at a cost per
+// pixel that grows with sigmaS^2; IP_blurBilateralGrid() approximates
+// it in time independent of sigmas. Rows are done in bands of
+// BILATERAL_BAND over threads threads, and each channel is filtered on
+// its own. The channels of I1 must be uchar. I1 and I2 may be the same
+// image.
+// Return 1 for success, 0 for failure.
+//! \brief	Exact bilateral filter.
+//! \param[in]	I1	- Input image.
+//! \param[in]	sigmaS	- Spatial standard deviation, in pixels.
+//! \param[in]	sigmaR	- Range standard deviation, in gray levels.
+//! \param[out]	I2	- Output image.
+//! \param[in]	threads	- Thread count; 0 selects all cores.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_blurBilateral(const ImagePtr &I1, double sigmaS, double sigmaR,
+		 const ImagePtr &I2, int threads = 0)
+{
+	if(!IP_bilateralCheck("IP_blurBilateral", I1, sigmaS, sigmaR))
+		return 0;
+
+	// spatial weights of the (2r+1) x (2r+1) window; range weights
+	int r  = (int) ceil(3*sigmaS);
+	int ww = 2*r + 1;
+	std::vector<float> ws(ww * ww), wr(MXGRAY);
+	for(int dy=-r; dy<=r; dy++)
+	for(int dx=-r; dx<=r; dx++)
+		ws[(dy+r)*ww + dx+r] = (float)
+			exp(-(dx*dx + dy*dy) / (2*sigmaS*sigmaS));
+	for(int i=0; i<MXGRAY; i++)
+		wr[i] = (float) exp(-(i*i) / (2*sigmaR*sigmaR));
+
+	// in place: read from a copy of the input
+	ImagePtr I = IP_inPlaceSource(I1, I2);
+	if(I1 != I2)
+		IP_allocImageInI(I2, I1->width(), I1->height(),
+				 I1->channelTypes());
+
+	int w = I->width ();
+	int h = I->height();
+	for(int ch=0; ch<I->maxChannel(); ch++) {
+		ChannelPtr<uchar> p1 = (*I )[ch];
+		ChannelPtr<uchar> p2 = (*I2)[ch];
+		const uchar *s = p1.buf();
+		uchar	    *d = p2.buf();
+		auto band = [&](int k) {
+			int y1 = MIN(h, (k+1) * BILATERAL_BAND);
+			for(int y=k*BILATERAL_BAND; y<y1; y++)
+			for(int x=0; x<w; x++) {
+				int   v   = s[(size_t) y*w + x];
+				float sum = 0;
+				float wt  = 0;
+				for(int yy=MAX(y-r, 0); yy<=MIN(y+r, h-1); yy++) {
+					const uchar *row = s + (size_t) yy*w;
+					const float *wy  = &ws[(yy-y+r)*ww + r-x];
+					for(int xx=MAX(x-r, 0); xx<=MIN(x+r, w-1); xx++) {
+						float f = wy[xx] * wr[ABS(row[xx] - v)];
+						sum += f * row[xx];
+						wt  += f;
+					}
+				}
+				d[(size_t) y*w + x] = (uchar) (int) (sum/wt + .5f);
+			}
+		};
+		IP_parallelFor((h + BILATERAL_BAND - 1) / BILATERAL_BAND, band,
+			       threads);
+	}
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurBilateralGrid:
+//
+// I2 <- Bilateral filter of I1, approximated on a bilateral grid (Paris
+// and Durand, 2006; Chen et al., 2007). The grid has a cell for every
+// sigmaS/res pixels in x and y and every sigmaR/res gray levels. Each
+// pixel adds its value and a unit weight to its nearest cell (splat),
+// the grid is blurred with a Gaussian of res cells along all three axes,
+// and each output pixel is the ratio of the blurred sums interpolated
+// trilinearly at its position and gray level (slice). The cost per pixel
+// is independent of the sigmas; a larger res gives a finer grid, closer
+// to IP_blurBilateral() and slower, with grid memory of 8 bytes a cell.
+// Grid rows, gray levels and output rows are spread over threads
+// threads. Where a cell would be narrower than a pixel, sigmaS < res,
+// the window of IP_blurBilateral() is small and it is used instead.
+// The channels of I1 must be uchar. I1 and I2 may be the same image.
+// Return 1 for success, 0 for failure.
+//! \brief	Bilateral filter on a bilateral grid.
+//! \param[in]	I1	- Input image.
+//! \param[in]	sigmaS	- Spatial standard deviation, in pixels.
+//! \param[in]	sigmaR	- Range standard deviation, in gray levels.
+//! \param[out]	I2	- Output image.
+//! \param[in]	res	- Grid cells per standard deviation.
+//! \param[in]	threads	- Thread count; 0 selects all cores.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_blurBilateralGrid(const ImagePtr &I1, double sigmaS, double sigmaR,
+		     const ImagePtr &I2, double res = 1, int threads = 0)
+{
+	if(!IP_bilateralCheck("IP_blurBilateralGrid", I1, sigmaS, sigmaR))
+		return 0;
+	if(res <= 0) {
+		fprintf(stderr, "IP_blurBilateralGrid: bad resolution %f\n", res);
+		return 0;
+	}
+	if(sigmaS < res)
+		return IP_blurBilateral(I1, sigmaS, sigmaR, I2, threads);
+
+	int   w  = I1->width ();
+	int   h  = I1->height();
+	float ss = (float) (sigmaS / res);	// pixels per cell
+	float sr = (float) (sigmaR / res);	// gray levels per cell
+
+	// grid blur kernel; a margin of R empty cells on every side lets
+	// the blur run without border tests on the cells that hold data
+	int R = (int) ceil(2*res);
+	std::vector<float> kern(2*R + 1);
+	for(int i=-R; i<=R; i++) kern[i+R] = (float) exp(-(i*i) / (2*res*res));
+	int gw = (int) ceil((w-1) / ss) + 1 + 2*R;
+	int gh = (int) ceil((h-1) / ss) + 1 + 2*R;
+	int gd = (int) ceil(MaxGray / sr) + 1 + 2*R;
+	size_t plane = (size_t) gd * gw;	// cells per grid row, [gz][gx]
+	std::vector<float> gv(plane * gh);	// sums of values
+	std::vector<float> gn(plane * gh);	// sums of weights
+
+	// in place: read from a copy of the input
+	ImagePtr I = IP_inPlaceSource(I1, I2);
+	if(I1 != I2) IP_allocImageInI(I2, w, h, I1->channelTypes());
+
+	// blur n lanes of len cells, stride apart, in place with tmp
+	auto blur = [&](float *g, int len, size_t stride, int n, float *tmp) {
+		for(int t=0; t<len; t++) {
+			float *o = tmp + (size_t) t*n;
+			for(int j=0; j<n; j++) o[j] = 0;
+			for(int i=MAX(t-R, 0); i<=MIN(t+R, len-1); i++) {
+				const float *a = g + i*stride;
+				float	     f = kern[i-t+R];
+				for(int j=0; j<n; j++) o[j] += f * a[j];
+			}
+		}
+		for(int t=0; t<len; t++)
+			memcpy(g + t*stride, tmp + (size_t) t*n, n * sizeof(float));
+	};
+
+	for(int ch=0; ch<I->maxChannel(); ch++) {
+		ChannelPtr<uchar> p1 = (*I )[ch];
+		ChannelPtr<uchar> p2 = (*I2)[ch];
+		const uchar *s = p1.buf();
+		uchar	    *d = p2.buf();
+
+		// splat and blur along x and z: grid rows are independent
+		auto row = [&](int gy) {
+			float *v = &gv[gy * plane];
+			float *n = &gn[gy * plane];
+			memset(v, 0, plane * sizeof(float));
+			memset(n, 0, plane * sizeof(float));
+			for(int y=0; y<h; y++) {
+				if((int) (y/ss + .5f) + R != gy) continue;
+				const uchar *p = s + (size_t) y*w;
+				for(int x=0; x<w; x++) {
+					size_t c = (size_t) ((int) (p[x]/sr + .5f) + R) * gw
+						 + (int) (x/ss + .5f) + R;
+					v[c] += p[x];
+					n[c] += 1;
+				}
+			}
+			ScratchScope scratch;
+			float *tmp = scratch.alloc<float>(plane);
+			for(int gz=0; gz<gd; gz++) {	// x: one lane per level
+				blur(v + gz*gw, gw, 1, 1, tmp);
+				blur(n + gz*gw, gw, 1, 1, tmp);
+			}
+			blur(v, gd, gw, gw, tmp);	// z: lanes are the gw cells
+			blur(n, gd, gw, gw, tmp);	// of a level
+		};
+		IP_parallelFor(gh, row, threads);
+
+		// blur along y: a task takes one gray level across all rows
+		auto level = [&](int gz) {
+			ScratchScope scratch;
+			float *tmp = scratch.alloc<float>((size_t) gh * gw);
+			blur(&gv[gz * gw], gh, plane, gw, tmp);
+			blur(&gn[gz * gw], gh, plane, gw, tmp);
+		};
+		IP_parallelFor(gd, level, threads);
+
+		// slice: interpolate both sums at every pixel
+		auto band = [&](int k) {
+			int y1 = MIN(h, (k+1) * BILATERAL_BAND);
+			for(int y=k*BILATERAL_BAND; y<y1; y++) {
+				float fy = y/ss + R;
+				int   iy = (int) fy;
+				float ay = fy - iy;
+				const uchar *p = s + (size_t) y*w;
+				uchar	    *q = d + (size_t) y*w;
+				for(int x=0; x<w; x++) {
+					float fx = x/ss + R;
+					float fz = p[x]/sr + R;
+					int   ix = (int) fx;
+					int   iz = (int) fz;
+					float ax = fx - ix;
+					float az = fz - iz;
+					size_t c = iy*plane + (size_t) iz*gw + ix;
+					float v = 0, n = 0;
+					for(int k=0; k<8; k++) {
+						size_t o = ((k&4) ? plane : 0) +
+							   ((k&2) ? gw    : 0) + (k&1);
+						float f = ((k&4) ? ay : 1-ay) *
+							  ((k&2) ? az : 1-az) *
+							  ((k&1) ? ax : 1-ax);
+						v += f * gv[c + o];
+						n += f * gn[c + o];
+					}
+					q[x] = (n > 0) ? (uchar) CLIP((int) (v/n + .5f), 0,
+								     MaxGray) : p[x];
+				}
+			}
+		};
+		IP_parallelFor((h + BILATERAL_BAND - 1) / BILATERAL_BAND, band,
+			       threads);
+	}
+	return 1;
+}
+
+//@}
@@ -0,0 +1,116 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPbits.tpp - Conversions between BW images and bit-packed channels.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPbits.tpp
+//! \brief	Conversions between BW images and bit-packed channels.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_allocImageInI(ImagePtr, int, int, int*);
+
+//! \addtogroup mmch
+//@{
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_packBits:
+//
+// B <- Bits of channel 0 of BW image I1: a bit is set where the pixel
+// is below thr, i.e., black pixels of a dithered image are set.
+// Return 1 for success, 0 if I1 is empty or channel 0 is not uchar.
+//! \brief	Pack black pixels of a BW image into a bit channel.
+//! \param[in]	I1  - Input image (uchar channel 0).
+//! \param[in]	thr - Pixels below \a thr are set.
+//! \param[out]	B   - Output bit channel.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_packBits(const ImagePtr &I1, int thr, BitChannel &B)
+{
+	if(I1.isNull() || I1->channelType(0) != UCHAR_TYPE) return 0;
+
+	int w = I1->width ();
+	int h = I1->height();
+	B.resize(w, h);
+
+	ChannelPtr<uchar> p1 = (*I1)[0];
+	const uchar *src = p1.buf();
+	for(int y=0; y<h; ++y) {
+		const uchar *in	 = src + (size_t) y*w;
+		BitWord	    *out = B.row(y);
+		for(int x0=0; x0<w; x0+=64) {
+			int n = MIN(64, w-x0);
+			BitWord word = 0;
+			for(int i=0; i<n; ++i)
+				word |= (BitWord) (in[x0+i] < thr) << i;
+			*out++ = word;
+		}
+	}
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_unpackBits:
+//
+// I2 <- BW image of bit channel B: set bits become 0 (black), clear
+// bits become MaxGray (white).
+//! \brief	Unpack a bit channel into a BW image.
+//! \param[in]	B  - Input bit channel.
+//! \param[out]	I2 - Output BW image.
+//
+inline void
+IP_unpackBits(const BitChannel &B, const ImagePtr &I2)
+{
+	int w = B.width ();
+	int h = B.height();
+	IP_allocImageInI(I2, w, h, BW_TYPE);
+
+	ChannelPtr<uchar> p2 = (*I2)[0];
+	uchar *out = p2.buf();
+	for(int y=0; y<h; ++y) {
+		const BitWord *in = B.row(y);
+		for(int x=0; x<w; ++x)
+			*out++ = ((in[x >> 6] >> (x & 63)) & 1) ? 0 : MaxGray;
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_bitsToQImage:
+//
+// q <- 1-bit QImage of bit channel B: set bits are black, clear bits
+// white. Rows are copied a byte at a time, without unpacking, into
+// QImage::Format_MonoLSB, whose bit order matches BitChannel.
+//! \brief	Convert a bit channel into a 1-bit QImage.
+//! \param[in]	B - Input bit channel.
+//! \param[out]	q - Output image.
+//
+inline void
+IP_bitsToQImage(const BitChannel &B, QImage &q)
+{
+	int w = B.width ();
+	int h = B.height();
+	q = QImage(w, h, QImage::Format_MonoLSB);
+	q.setColorCount(2);
+	q.setColor(0, qRgb(255, 255, 255));
+	q.setColor(1, qRgb(0, 0, 0));
+
+	int n = (w + 7) / 8;
+	for(int y=0; y<h; ++y) {
+		const BitWord *in  = B.row(y);
+		uchar	      *out = q.scanLine(y);
+		for(int i=0; i<n; ++i)
+			out[i] = (uchar) (in[i >> 3] >> (8 * (i & 7)));
+	}
+}
+
+//@}
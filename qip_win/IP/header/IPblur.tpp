@@ -13,6 +13,17 @@
 
 using namespace IP;
 
+// ----------------------------------------------------------------------
+// IP.lib carries its own compiled copies of IP_blur1D() and blur1D_odd(),
+// which its IP_blur() and IP_sharpen() call, so the text below must stay
+// as it was compiled: it allocates an MXRES image per scanline and
+// cannot blur scanlines longer than MXRES. Those library paths are out
+// of reach of the headers. Header code (IP_blurMT(), IP_blurView(),
+// BlurRows and the nail art pipelines) blurs with IP_blur1DScratch()
+// of IPblurMT.tpp instead, which draws its buffer from the per-thread
+// scratch arena and has no length limit.
+//
+
 extern Image *IP_allocImage(int, int, int*);
 template<class T> void blur1D_odd(ChannelPtr<T>, int, int, double, ChannelPtr<T>);
 
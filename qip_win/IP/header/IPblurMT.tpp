@@ -0,0 +1,623 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPblurMT.tpp - Multithreaded, cache-blocked blur and sharpen.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPblurMT.tpp
+//! \brief	Multithreaded, cache-blocked blur and sharpen.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_blur	      (ImagePtr, double, double, ImagePtr);
+extern void IP_copyHeader     (ImagePtr, int, ImagePtr);
+extern void IP_castChannels   (ImagePtr, int*, ImagePtr);
+extern void IP_castChannelsMin(ImagePtr, int, ImagePtr);
+extern int  IP_subtractImage  (ImagePtr, ImagePtr, ImagePtr);
+extern int  IP_multiplyConst  (ImagePtr, double *, ImagePtr);
+extern int  IP_addImage	      (ImagePtr, ImagePtr, ImagePtr);
+
+template<class T> void blur1DScratch_odd(ChannelPtr<T>, int, int, double, ChannelPtr<T>);
+
+//! \addtogroup filtnbr
+//@{
+
+// ----------------------------------------------------------------------
+// rows per work item of the horizontal pass, and columns per strip of
+// the vertical pass (one 64-byte cache line of uchar pixels per row)
+//
+enum { BLUR_BAND = 16, BLUR_STRIP = 64 };
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blur1DScratch:
+//
+// dst <- Blur src with 1D box filter of width ww. Same output as
+// IP_blur1D(), but the working buffer is drawn from the per-thread
+// scratch arena instead of an MXRES image, so len is not limited to
+// MXRES. IP_blur1D() itself is left as compiled into the library.
+//! \brief	Image blurring (1D version) with a scratch arena buffer.
+//! \details	\a dst <- Blur \a src with 1D box filter of width \a ww.
+//! param[in]	src - ChannelPtr to input scanline.
+//! param[in]	len - Number of pixels in \a src.
+//! param[in]	stride - Distance between successive input pixels (in pixels).
+//!		stride = 1 for processing rows.
+//!		stride = scanline width for processing columns.
+//! param[in]	ww - Width of blurring kernel.
+//! param[out]	dst - ChannelPtr to output scanline.
+//!		Distance between successive output pixels is \a stride.
+//
+template<class T>
+void
+IP_blur1DScratch(ChannelPtr<T> src, int len, int stride, double ww, ChannelPtr<T> dst)
+{
+	// error checking: filter width exceeds scanline length
+	if(ww > len) {
+		fprintf(stderr, "IP_blur1DScratch: filter exceeds scanline (%f>%d)\n",
+			ww, len);
+		return;
+	}
+
+	// trivial case: filter width is less than a pixel
+	if(ww <= 1.) {
+		if(src != dst) {
+			// copy src to dst
+			for(int i=0; i<len; ++i) {
+				*dst  = *src;
+				 dst += stride;
+				 src += stride;
+			}
+		}
+		return;
+	}
+
+	// check for odd window size: use simpler blur fct
+	if(ww == (int) ww && (int) ww % 2) {
+		blur1DScratch_odd(src, len, stride, ww, dst);
+		return;
+	}
+
+	// working buffer from the per-thread scratch arena
+	ScratchScope scratch;
+
+	// init vars
+	ChannelPtr<T> buf(scratch.alloc<T>(len));	// buffer channel
+	double ww2 = (ww  -  1.) / 2.;		// filter half-width
+	double wt1 =  ww2 - (int) ww2;		// partial coverage on right
+	double wt2 =  1. - wt1;			// partial coverage on left
+
+	// srcp is ptr to row buffer of input pixels; make copy if necessary
+	ChannelPtr<T> srcp;
+	if(src!=dst && stride==1)
+		srcp = src;
+	else {
+		for(int i=0; i<len; ++i, src+=stride) buf[i] = *src;
+		srcp = buf;
+	}
+
+	// accumulate sufficient pixels to fill right half of window
+	// centered at the left-most pixel in scanline
+	double	num = ww2 + 1;			// +1: include center pixel
+	int	lim = (int) num;		// number of pixels to fetch
+	double	sum = 0;			// accumulator
+	int		i = 0;			// dummy variable
+	for(; i<lim; ++i) sum += *srcp++;	// sum of pixels in window
+	int trail = i;				// number of positions to fetch at right end later
+
+	// continue collecting pixels to fill entire window
+	double s;
+	for(; num < ww; ++i) {
+		 // s is right fractional part; add it to integral sum
+		 s    = *srcp * wt1;		// pixel contribution
+		*dst  = (T) ((sum+s) / num);	// weighted sum
+		 dst +=  stride;		// advance pointer
+		 sum += *srcp++;		// slide window over full pixel
+		 num +=  1;			// number of accumulated pixels
+	}
+
+	// the window totally fits; continue until the end of the scanline;
+	// exploit the fact that the running sum can be computed incrementally
+	// by subtracting the outgoing pixel and adding the incoming one.
+	int offset = -i;			// offset to outgoing pixel
+	for(; i<len; ++i) {
+		 // s is difference of right and left fractional parts
+		 s    = (*srcp * wt1) - (srcp[offset] * wt2);
+		*dst  = (T) ((sum+s) / ww);	// weighted sum
+		 dst +=  stride;		// advance pointer
+		 sum -=  srcp[offset];		// subtract outgoing pixel
+		 sum += *srcp++;		// add incoming pixel
+	}
+
+	// the window now falls off the trailing end of the scanline
+	srcp += offset;
+	num   = ww - wt1;
+	for(i=0; i<trail; ++i) {
+		 s    = *srcp * wt2;		// pixel contribution
+		*dst  = (T) ((sum-s) / num);	// weighted sum
+		 dst +=  stride;		// advance pointer
+		 sum -= *srcp++;		// slide window off scanline
+		 num -= 1;			// number of accumulated pixels
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// blur1DScratch_odd:
+//
+// dst <- Blur src with 1D box filter of width ww (odd). Same output as
+// blur1D_odd().
+//! \brief	Image blurring (1D version) for odd-sized kernel width.
+//! \details	\a dst <- Blur \a src with 1D box filter of width \a ww,
+//!		when \a ww is known to be odd-valued.
+//! param[in]	src - ChannelPtr to input scanline.
+//! param[in]	len - Number of pixels in \a src.
+//! param[in]	stride - Distance between successive input pixels (in pixels).
+//!		stride = 1 for processing rows.
+//!		stride = scanline width for processing columns.
+//! param[in]	ww - Width of blurring kernel.
+//! param[out]	dst - ChannelPtr to output scanline.
+//!		Distance between successive output pixels is \a stride.
+//
+template<class T> void
+blur1DScratch_odd(ChannelPtr<T> src, int len, int stride, double ww, ChannelPtr<T> dst)
+{
+	// working buffer from the per-thread scratch arena
+	ScratchScope scratch;
+
+	// srcp points to row buffer of input pixels; make copy if necessary
+	ChannelPtr<T> srcp;			// ptr to input pixels
+	ChannelPtr<T> buf(scratch.alloc<T>(len));	// buffer channel
+	if(src!=dst && stride==1)
+		srcp = src;
+	else {
+		for(int i=0; i<len; ++i, src+=stride) buf[i] = *src;
+		srcp = buf;
+	}
+
+	// init vars
+	int ww2    = (int)  (ww/2);		// filter half-width
+	int offset = (int) (-ww  );		// offset to outgoing pixel
+
+	// accumulate sufficient pixels to fill right half of window
+	// centered at the left-most pixel in scanline
+	double	num = ww2;			// doesn't include center pixel
+	int	lim = (int) num;		// number of pixels to fetch
+	double	sum = 0;			// accumulator
+	int	i   = 0;			// dummy variable
+	for(; i<lim; ++i) sum += *srcp++;	// sum of pixels in window
+
+	// continue collecting pixels to fill entire window
+	for(; num < ww; ++i) {
+		*dst  =  (T) (sum / num);	// weighted sum
+		 dst +=  stride;		// advance pointer
+		 sum += *srcp++;		// running  sum
+		 num +=  1;			// number of accumulated pixels
+	}
+
+	// the window totally fits; continue until the end of the scanline;
+	// exploit the fact that the running sum can be computed incrementally
+	// by subtracting the outgoing pixel and adding the incoming one.
+	for(; i<len; ++i) {
+		 sum -=  srcp[offset];		// subtract outgoing pixel
+		 sum += *srcp++;		// add incoming pixel
+		*dst  = (T) (sum / ww);		// weighted sum
+		 dst +=  stride;		// advance pointer
+	}
+
+	// the window now falls off the trailing end of the scanline
+	srcp += offset;
+	num   = ww - 1;
+	for(i=0; i<ww2; ++i) {
+		 sum -= srcp[i];		// subtract outgoing pixel
+		*dst  = (T) (sum / num);	// weighted sum
+		 dst += stride;			// advance pointer
+		 num -= 1;			// number of accumulated pixels
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurRowsMT:
+//
+// dst <- Blur the h rows of the w x h channel src with filter width ww.
+// Rows are done in bands of BLUR_BAND over threads threads. For integer
+// widths a band is transposed so that its rows become the lanes of
+// IP_boxLanes(), blurred with vector instructions, and transposed back;
+// other widths are blurred row by row with IP_blur1DScratch(). Either
+// way the output is that of IP_blur1D() on every row. src and dst may be
+// the same channel.
+//
+template<class T>
+void
+IP_blurRowsMT(ChannelPtr<T> src, int w, int h, double ww,
+	      ChannelPtr<T> dst, int threads)
+{
+	const T *s0 = src.buf();
+	T	*d0 = dst.buf();
+	bool box = (ww == (int) ww);
+	auto band = [&](int k) {
+		int y0 = k * BLUR_BAND;
+		int n  = MIN(BLUR_BAND, h - y0);
+		if(!box) {
+			for(int y=y0; y<y0+n; y++) {
+				size_t off = (size_t) y * w;
+				IP_blur1DScratch(ChannelPtr<T>((T *) s0 + off), w, 1,
+						 ww, ChannelPtr<T>(d0 + off));
+			}
+			return;
+		}
+
+		ScratchScope scratch;
+		T *in  = scratch.alloc<T>((size_t) w * n);	// w samples of n lanes
+		T *out = scratch.alloc<T>((size_t) w * n);
+		for(int j=0; j<n; j++) {
+			const T *s = s0 + (size_t) (y0+j) * w;
+			for(int x=0; x<w; x++) in[(size_t) x*n + j] = s[x];
+		}
+		IP_boxLanes(in, n, w, n, (int) ww, out, n);
+		for(int j=0; j<n; j++) {
+			T *d = d0 + (size_t) (y0+j) * w;
+			for(int x=0; x<w; x++) d[x] = out[(size_t) x*n + j];
+		}
+	};
+	IP_parallelFor((h + BLUR_BAND - 1) / BLUR_BAND, band, threads);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurColumnsMT:
+//
+// dst <- Blur the w columns of the w x h channel src with filter width
+// ww. Columns are done in strips of BLUR_STRIP over threads threads, and
+// the output is that of IP_blur1D() on every column. For integer widths
+// the strip is copied out row by row and its columns are blurred as the
+// lanes of IP_boxLanes(), which writes the output rows straight to dst.
+// For other widths the strip is transposed, each column is blurred with
+// IP_blur1DScratch() at stride 1, and the results are copied back. Either way
+// every row of a strip is read and written as one cache line.
+// src and dst may be the same channel.
+//
+template<class T>
+void
+IP_blurColumnsMT(ChannelPtr<T> src, int w, int h, double ww,
+		 ChannelPtr<T> dst, int threads)
+{
+	const T *s0 = src.buf();
+	T	*d0 = dst.buf();
+	bool box    = (ww == (int) ww);
+	int  strips = (w + BLUR_STRIP - 1) / BLUR_STRIP;
+	auto strip = [&](int k) {
+		int x0 = k * BLUR_STRIP;
+		int n  = MIN(BLUR_STRIP, w - x0);
+
+		ScratchScope scratch;
+		T *col = scratch.alloc<T>((size_t) n * h);	// h rows of n
+		if(box) {
+			for(int y=0; y<h; y++)
+				memcpy(col + (size_t) y*n, s0 + (size_t) y*w + x0,
+				       n * sizeof(T));
+			IP_boxLanes(col, n, h, n, (int) ww, d0 + x0, w);
+			return;
+		}
+
+		// transpose strip into col: n columns of h
+		T *out = scratch.alloc<T>(h);
+		for(int y=0; y<h; y++) {
+			const T *s = s0 + (size_t) y*w + x0;
+			for(int i=0; i<n; i++) col[(size_t) i*h + y] = s[i];
+		}
+
+		// blur each column and write it back
+		for(int i=0; i<n; i++) {
+			IP_blur1DScratch(ChannelPtr<T>(col + (size_t) i*h), h, 1,
+					 ww, ChannelPtr<T>(out));
+			T *d = d0 + x0 + i;
+			for(int y=0; y<h; y++, d+=w) *d = out[y];
+		}
+	};
+	IP_parallelFor(strips, strip, threads);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurMT:
+//
+// I2 <- Blur I1 with a xsz x ysz box filter. Same result as IP_blur():
+// channels are blurred along rows and then along columns with
+// IP_blur1D(), but rows are split into bands over threads threads,
+// columns are blurred in cache-line strips, and integer filter widths
+// use the vector box filter of IP_boxLanes() (see IP_blurRowsMT() and
+// IP_blurColumnsMT()).
+// Images with channels other than uchar, and filter sizes that
+// IP_blur() rejects or that need no filtering, are passed on to
+// IP_blur(). Only the first reach the MXRES-limited IP_blur1D() compiled
+// into IP.lib (see IPblur.tpp); for the others IP_blur() copies the
+// image. I1 and I2 may be the same image.
+//! \brief	Multithreaded image blurring.
+//! \param[in]	I1	 - Input image.
+//! \param[in]	xsz, ysz - Filter width and height.
+//! \param[out]	I2	 - Output image.
+//! \param[in]	threads	 - Thread count; 0 selects all cores.
+//
+inline void
+IP_blurMT(const ImagePtr &I1, double xsz, double ysz, const ImagePtr &I2,
+	  int threads = 0)
+{
+	int w = I1->width ();
+	int h = I1->height();
+	bool ok = (xsz > 1 || ysz > 1) &&
+		  xsz < MXBLUR-1 && ysz < MXBLUR-1 && xsz <= w && ysz <= h;
+	for(int ch=0; ok && ch<I1->maxChannel(); ch++)
+		ok = (I1->channelType(ch) == UCHAR_TYPE);
+	if(!ok) {
+		IP_blur(I1, xsz, ysz, I2);
+		return;
+	}
+
+	IP_copyHeader(I1, 1, I2);
+	for(int ch=0; ch<I1->maxChannel(); ch++) {
+		ChannelPtr<uchar> p1 = (*I1)[ch];
+		ChannelPtr<uchar> p2 = (*I2)[ch];
+		uchar *s = (uchar *) p1.buf();
+		uchar *d = (uchar *) p2.buf();
+
+		// blur rows
+		if(xsz > 1) {
+			IP_blurRowsMT(ChannelPtr<uchar>(s), w, h, xsz,
+				      ChannelPtr<uchar>(d), threads);
+			s = d;
+		}
+
+		// blur columns of the row-blurred channel (or of I1)
+		if(ysz > 1)
+			IP_blurColumnsMT(ChannelPtr<uchar>(s), w, h, ysz,
+					 ChannelPtr<uchar>(d), threads);
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_sharpenMT:
+//
+// I2 <- Sharpen I1 by unsharp masking: I1 + fctr*(I1 - blur(I1)), where
+// blur is a xsz x ysz box filter. Same steps and result as IP_sharpen();
+// the blur is done by IP_blurMT().
+//! \brief	Multithreaded image sharpening.
+//! \param[in]	I1	 - Input image.
+//! \param[in]	xsz, ysz - Filter width and height.
+//! \param[in]	fctr	 - Sharpening factor.
+//! \param[out]	I2	 - Output image.
+//! \param[in]	threads	 - Thread count; 0 selects all cores.
+//
+inline void
+IP_sharpenMT(const ImagePtr &I1, double xsz, double ysz, double fctr,
+	     const ImagePtr &I2, int threads = 0)
+{
+	// channel types of I1 and per-channel factor
+	int    types[MXCHANNEL+1];
+	double f    [MXCHANNEL];
+	int    n = I1->maxChannel();
+	for(int ch=0; ch<n; ch++) {
+		types[ch] = I1->channelType(ch);
+		f    [ch] = fctr;
+	}
+	types[n] = -1;
+
+	// I2 = I1 + fctr*(I1 - blur), in at least short precision
+	ImagePtr I;
+	IP_blurMT(I1, xsz, ysz, I, threads);
+	IP_castChannelsMin(I, SHORT_TYPE, I);
+	IP_subtractImage(I1, I, I);
+	IP_multiplyConst(I, f, I);
+	IP_addImage(I1, I, I2);
+	IP_castChannels(I2, types, I2);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BlurRows class declaration
+//! \brief	Row-at-a-time vertical box filter.
+//! \details	Blurs the columns of an image of len rows of n uchar
+//!		pixels that is fed to it one row at a time, top to bottom.
+//!		Every column gets the output of IP_blur1D() with width ww,
+//!		1 < ww <= len. Blurred rows come out in order, up to about
+//!		ww/2 rows behind the rows pushed; the rest are drained by
+//!		flush() once all len rows are in. Integer widths step the
+//!		schedule of IP_boxLanes() with IP_boxStep(); other widths
+//!		repeat the double arithmetic of IP_blur1D(). Only the last
+//!		ww or so rows are kept, in a ring.
+//
+class BlurRows {
+public:
+	BlurRows(int len, int n, double ww);
+
+	int	push (const uchar *in, uchar *out);	// add next row
+	int	flush(uchar *out);			// drain a trailing row
+
+private:
+	const uchar *row(int t) const			// pushed row t
+			{ return &m_rows[(size_t) (t % m_ring) * m_n]; }
+
+	int		 m_len;			// number of rows
+	int		 m_n;			// pixels per row
+	double		 m_ww;			// filter width
+	bool		 m_box;			// integer width: IP_boxStep()
+	int		 m_half;		// rows drained by flush()
+	int		 m_lead;		// first row of the full window
+	int		 m_ring;		// rows in m_rows
+	int		 m_t;			// index of next row pushed
+	int		 m_i;			// index of next row flushed
+	double		 m_wt1, m_wt2;		// partial end weights
+	double		 m_num;			// window weight
+	std::vector<uchar> m_rows;		// ring of pushed rows
+	std::vector<int>   m_acc;		// running column sums
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BlurRows::BlurRows:
+//
+// Constructor for blurring the columns of len rows of n pixels with a
+// box filter of width ww, 1 < ww <= len.
+//! \brief	Constructor.
+//! \param[in]	len - Number of rows.
+//! \param[in]	n   - Pixels per row.
+//! \param[in]	ww  - Filter width.
+//
+inline
+BlurRows::BlurRows(int len, int n, double ww)
+	: m_len (len),
+	  m_n	(n),
+	  m_ww	(ww),
+	  m_box (ww == (int) ww),
+	  m_t	(0),
+	  m_i	(0)
+{
+	// fractional widths (IP_blur1D): the first m_half rows are summed
+	// before any output, and rows up to m_lead widen the window
+	double ww2 = (ww - 1.) / 2.;
+	m_wt1  = ww2 - (int) ww2;
+	m_wt2  = 1. - m_wt1;
+	m_num  = ww2 + 1;
+	m_half = (int) m_num;
+	m_lead = m_half;
+	for(double num=m_num; num < ww; num += 1) m_lead++;
+
+	// integer widths (IP_boxLanes): half-width of the window
+	if(m_box) {
+		m_half = (int) ww / 2;
+		m_lead = (int) ww;
+	}
+	m_ring = m_lead;
+	m_rows.assign((size_t) m_ring * n, 0);
+	m_acc .assign(n, 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BlurRows::push:
+//
+// Add the next row in. If that completes a blurred row, write it into
+// out and return its index; else return -1.
+//! \brief	Add the next row.
+//! \param[in]	in  - Input row (n pixels).
+//! \param[out]	out - Blurred row (n pixels), if one is ready.
+//! \return	Index of the blurred row written to out, or -1.
+//
+inline int
+BlurRows::push(const uchar *in, uchar *out)
+{
+	int    t    = m_t++;
+	uchar *slot = &m_rows[(size_t) (t % m_ring) * m_n];	// row t-m_ring
+	int    y    = -1;
+	int   *acc  = &m_acc[0];
+
+	if(m_box) {
+		int ww = (int) m_ww;
+		int r  = m_half;
+		if(ww % 2) {
+			// odd width 2r+1: schedule of IP_boxLanes()
+			if(t < 2*r) {
+				y = (t >= r-1) ? t-r+1 : -1;
+				IP_boxStep<uchar>(acc, m_n, in, 0, false, t+1,
+						  y >= 0 ? out : (uchar *) 0);
+			} else if(t == 2*r) {
+				IP_boxStep<uchar>(acc, m_n, in, 0, false, 1,
+						  (uchar *) 0);
+			} else {
+				y = t-r;
+				IP_boxStep<uchar>(acc, m_n, in, slot, false, ww, out);
+			}
+		} else {
+			// even width 2r: half-weight end rows
+			if(t < r) {
+				IP_boxStep<uchar>(acc, m_n, in, 0, false, 1,
+						  (uchar *) 0);
+			} else if(t < 2*r) {
+				y = t-r;
+				IP_boxStep<uchar>(acc, m_n, in, 0, true,
+						  2*r+1+2*y, out);
+			} else {
+				y = t-r;
+				IP_boxStep<uchar>(acc, m_n, in, slot, true, 2*ww, out);
+			}
+		}
+	} else if(t < m_half) {
+		// fill right half of the window centered at row 0
+		for(int x=0; x<m_n; ++x) acc[x] += in[x];
+	} else if(t < m_lead) {
+		// window still growing
+		y = t - m_half;
+		for(int x=0; x<m_n; ++x) {
+			double s = in[x] * m_wt1;
+			out[x]	 = (uchar) ((acc[x] + s) / m_num);
+			acc[x]	+= in[x];
+		}
+		m_num += 1;
+	} else {
+		// window totally fits; slot holds the outgoing row
+		y = t - m_half;
+		for(int x=0; x<m_n; ++x) {
+			double s = (in[x] * m_wt1) - (slot[x] * m_wt2);
+			out[x]	 = (uchar) ((acc[x] + s) / m_ww);
+			acc[x]	+= in[x] - slot[x];
+		}
+	}
+	memcpy(slot, in, m_n);
+	return y;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BlurRows::flush:
+//
+// Once all len rows have been pushed, write the next of the blurred
+// rows still pending into out, as the window falls off the last row.
+// Return its index, or -1 when all rows are done.
+//! \brief	Drain a trailing row.
+//! \param[out]	out - Blurred row (n pixels).
+//! \return	Index of the blurred row written to out, or -1.
+//
+inline int
+BlurRows::flush(uchar *out)
+{
+	if(m_t < m_len || m_i >= m_half) return -1;
+
+	int  i	 = m_i++;
+	int *acc = &m_acc[0];
+	if(m_box) {
+		int ww = (int) m_ww;
+		if(ww % 2)
+			IP_boxStep<uchar>(acc, m_n, (uchar *) 0, row(m_len-ww+i),
+					  false, 2*m_half-i, out);
+		else	IP_boxStep<uchar>(acc, m_n, (uchar *) 0, row(m_len-ww+i),
+					  true, 2*ww-1-2*i, out);
+		return m_len - m_half + i;
+	}
+
+	if(!i) m_num = m_ww - m_wt1;
+	const uchar *p = row(m_len - m_lead + i);
+	for(int x=0; x<m_n; ++x) {
+		double s = p[x] * m_wt2;
+		out[x]	 = (uchar) ((acc[x] - s) / m_num);
+		acc[x]	-= p[x];
+	}
+	m_num -= 1;
+	return m_len - m_half + i;
+}
+
+//@}
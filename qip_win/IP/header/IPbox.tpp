@@ -0,0 +1,322 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPbox.tpp - Integer running-sum box filter over parallel lanes.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPbox.tpp
+//! \brief	Integer running-sum box filter over parallel lanes.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+//! \addtogroup filtnbr
+//@{
+
+// ----------------------------------------------------------------------
+// The filters below blur many scanlines at once. The scanlines are
+// interleaved as lanes: sample t of lane j is at src[t*stride + j], so
+// one row of an image holds a lane per column, and a transposed band of
+// rows holds a lane per row. Every step of the running sum adds one
+// sample to all lanes with vector instructions.
+//
+// For integer filter widths the sums are kept in int accumulators and
+// each output is a truncated quotient of integers, which reproduces
+// IP_blur1D() exactly: its double sums of uchar or short samples are
+// exact, and so is the truncation of their quotient. Odd widths follow
+// blur1D_odd(). Even widths have half-weight end samples; they are done
+// in units of half a sample, where an output is (acc + acc')/2num and
+// acc and acc' are the sums before and after the step.
+// Vector quotients are taken in float: for |a| < 2^24 and 0 < b < 2^24,
+// trunc(float(a)/float(b)) equals the integer quotient a/b, and a is
+// below 2 * 32767 * MXBLUR here.
+//
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_boxLoad*, IP_boxStore*:
+//
+// Widen 4, 8 or 16 uchar or short samples to int lanes, and narrow them
+// back. Outputs of a box filter lie in the range of its inputs, so the
+// narrowing never saturates.
+//
+#if defined(IP_SSE2)
+IP_TARGET_SSE2 inline __m128i
+IP_boxLoadSSE2(const uchar *p)
+{
+	int v;
+	memcpy(&v, p, 4);
+	__m128i z = _mm_setzero_si128();
+	__m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), z);
+	return _mm_unpacklo_epi16(x, z);
+}
+
+IP_TARGET_SSE2 inline __m128i
+IP_boxLoadSSE2(const short *p)
+{
+	__m128i x = _mm_loadl_epi64((const __m128i *) p);
+	return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+
+IP_TARGET_SSE2 inline void
+IP_boxStoreSSE2(__m128i x, uchar *p)
+{
+	__m128i y = _mm_packs_epi32(x, x);
+	int v = _mm_cvtsi128_si32(_mm_packus_epi16(y, y));
+	memcpy(p, &v, 4);
+}
+
+IP_TARGET_SSE2 inline void
+IP_boxStoreSSE2(__m128i x, short *p)
+{
+	_mm_storel_epi64((__m128i *) p, _mm_packs_epi32(x, x));
+}
+#endif
+
+#if defined(IP_AVX2)
+IP_TARGET_AVX2 inline __m256i
+IP_boxLoadAVX2(const uchar *p)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) p));
+}
+
+IP_TARGET_AVX2 inline __m256i
+IP_boxLoadAVX2(const short *p)
+{
+	return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) p));
+}
+
+IP_TARGET_AVX2 inline void
+IP_boxStoreAVX2(__m256i x, uchar *p)
+{
+	__m128i y = _mm_packs_epi32(_mm256_castsi256_si128(x),
+				    _mm256_extracti128_si256(x, 1));
+	_mm_storel_epi64((__m128i *) p, _mm_packus_epi16(y, y));
+}
+
+IP_TARGET_AVX2 inline void
+IP_boxStoreAVX2(__m256i x, short *p)
+{
+	_mm_storeu_si128((__m128i *) p,
+			 _mm_packs_epi32(_mm256_castsi256_si128(x),
+					 _mm256_extracti128_si256(x, 1)));
+}
+#endif
+
+#if defined(IP_AVX512)
+IP_TARGET_AVX512 inline __m512i
+IP_boxLoadAVX512(const uchar *p)
+{
+	return _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *) p));
+}
+
+IP_TARGET_AVX512 inline __m512i
+IP_boxLoadAVX512(const short *p)
+{
+	return _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *) p));
+}
+
+IP_TARGET_AVX512 inline void
+IP_boxStoreAVX512(__m512i x, uchar *p)
+{
+	_mm_storeu_si128((__m128i *) p, _mm512_cvtepi32_epi8(x));
+}
+
+IP_TARGET_AVX512 inline void
+IP_boxStoreAVX512(__m512i x, short *p)
+{
+	_mm256_storeu_si256((__m256i *) p, _mm512_cvtepi32_epi16(x));
+}
+#endif
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_boxStepSSE2, IP_boxStepAVX2, IP_boxStepAVX512:
+//
+// Vector parts of IP_boxStep(): do lanes i, i+4, ... (i+8, i+16) while
+// a whole vector fits in n. Return the first lane not done.
+//
+#if defined(IP_SSE2)
+template<class T>
+IP_TARGET_SSE2 inline int
+IP_boxStepSSE2(int *acc, int i, int n, const T *add, const T *sub,
+	       bool even, int d, T *out)
+{
+	const __m128 dv = _mm_set1_ps((float) d);
+	for(; i+4<=n; i+=4) {
+		__m128i a0 = _mm_loadu_si128((const __m128i *) (acc + i));
+		__m128i a  = a0;
+		if(add) a = _mm_add_epi32(a, IP_boxLoadSSE2(add + i));
+		if(sub) a = _mm_sub_epi32(a, IP_boxLoadSSE2(sub + i));
+		_mm_storeu_si128((__m128i *) (acc + i), a);
+		if(out) {
+			__m128i v = even ? _mm_add_epi32(a0, a) : a;
+			__m128  q = _mm_div_ps(_mm_cvtepi32_ps(v), dv);
+			IP_boxStoreSSE2(_mm_cvttps_epi32(q), out + i);
+		}
+	}
+	return i;
+}
+#endif
+
+#if defined(IP_AVX2)
+template<class T>
+IP_TARGET_AVX2 inline int
+IP_boxStepAVX2(int *acc, int i, int n, const T *add, const T *sub,
+	       bool even, int d, T *out)
+{
+	const __m256 dv = _mm256_set1_ps((float) d);
+	for(; i+8<=n; i+=8) {
+		__m256i a0 = _mm256_loadu_si256((const __m256i *) (acc + i));
+		__m256i a  = a0;
+		if(add) a = _mm256_add_epi32(a, IP_boxLoadAVX2(add + i));
+		if(sub) a = _mm256_sub_epi32(a, IP_boxLoadAVX2(sub + i));
+		_mm256_storeu_si256((__m256i *) (acc + i), a);
+		if(out) {
+			__m256i v = even ? _mm256_add_epi32(a0, a) : a;
+			__m256  q = _mm256_div_ps(_mm256_cvtepi32_ps(v), dv);
+			IP_boxStoreAVX2(_mm256_cvttps_epi32(q), out + i);
+		}
+	}
+	return i;
+}
+#endif
+
+#if defined(IP_AVX512)
+template<class T>
+IP_TARGET_AVX512 inline int
+IP_boxStepAVX512(int *acc, int i, int n, const T *add, const T *sub,
+		 bool even, int d, T *out)
+{
+	const __m512 dv = _mm512_set1_ps((float) d);
+	for(; i+16<=n; i+=16) {
+		__m512i a0 = _mm512_loadu_si512(acc + i);
+		__m512i a  = a0;
+		if(add) a = _mm512_add_epi32(a, IP_boxLoadAVX512(add + i));
+		if(sub) a = _mm512_sub_epi32(a, IP_boxLoadAVX512(sub + i));
+		_mm512_storeu_si512(acc + i, a);
+		if(out) {
+			__m512i v = even ? _mm512_add_epi32(a0, a) : a;
+			__m512  q = _mm512_div_ps(_mm512_cvtepi32_ps(v), dv);
+			IP_boxStoreAVX512(_mm512_cvttps_epi32(q), out + i);
+		}
+	}
+	return i;
+}
+#endif
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_boxStep:
+//
+// One step of the running sum over n lanes: acc += add - sub, where add
+// and sub may be null. If out is not null, out <- acc/d, or
+// (old acc + acc)/d if even is set (see above). The widest instruction
+// set the CPU supports does as many lanes as fit, and narrower ones and
+// scalar code finish the rest.
+//! \brief	Step a box filter over parallel lanes.
+//! \param[in,out] acc	- Running sums, one per lane.
+//! \param[in]	n	- Number of lanes.
+//! \param[in]	add	- Samples entering the window, or null.
+//! \param[in]	sub	- Samples leaving the window, or null.
+//! \param[in]	even	- Output the sum of old and new acc.
+//! \param[in]	d	- Divisor.
+//! \param[out]	out	- Output samples, or null.
+//
+template<class T>
+inline void
+IP_boxStep(int *acc, int n, const T *add, const T *sub, bool even, int d,
+	   T *out)
+{
+	int i = 0;
+#if defined(IP_AVX512)
+	if(IP_hasAVX512()) i = IP_boxStepAVX512(acc, i, n, add, sub, even, d, out);
+#endif
+#if defined(IP_AVX2)
+	if(IP_hasAVX2())   i = IP_boxStepAVX2  (acc, i, n, add, sub, even, d, out);
+#endif
+#if defined(IP_SSE2)
+	if(IP_hasSSE2())   i = IP_boxStepSSE2  (acc, i, n, add, sub, even, d, out);
+#endif
+	for(; i<n; i++) {
+		int a0 = acc[i];
+		int a  = a0;
+		if(add) a += add[i];
+		if(sub) a -= sub[i];
+		acc[i] = a;
+		if(out) out[i] = (T) ((even ? a0 + a : a) / d);
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_boxLanes:
+//
+// dst <- Blur n lanes of len samples with a box filter of integer width
+// ww, 1 < ww <= len. Sample t of lane j is src[t*sstride + j] and
+// dst[t*dstride + j]; src and dst must not overlap. Each lane gets
+// exactly the output of IP_blur1D() with the same width, for uchar and
+// short samples.
+//! \brief	Box filter over parallel lanes.
+//! \param[in]	src	- Input samples.
+//! \param[in]	sstride	- Distance between samples t and t+1 of src.
+//! \param[in]	len	- Number of samples per lane.
+//! \param[in]	n	- Number of lanes.
+//! \param[in]	ww	- Filter width (an integer).
+//! \param[out]	dst	- Output samples.
+//! \param[in]	dstride	- Distance between samples t and t+1 of dst.
+//
+template<class T>
+void
+IP_boxLanes(const T *src, int sstride, int len, int n, int ww, T *dst,
+	    int dstride)
+{
+	ScratchScope scratch;
+	int *acc = scratch.alloc<int>(n);
+	for(int j=0; j<n; j++) acc[j] = 0;
+
+	// sample t of all input and output lanes
+	auto X = [&](int t) { return src + (size_t) t * sstride; };
+	auto Y = [&](int t) { return dst + (size_t) t * dstride; };
+	if(ww % 2) {
+		// odd width 2r+1 (blur1D_odd): the first r+1 outputs
+		// average the r+t samples before the window center
+		int r = ww / 2;
+		for(int t=0; t<2*r; t++)
+			IP_boxStep<T>(acc, n, X(t), 0, false, t+1,
+				      t >= r-1 ? Y(t-r+1) : (T *) 0);
+		IP_boxStep<T>(acc, n, X(2*r), 0, false, 1, (T *) 0);
+
+		// window totally fits
+		for(int t=ww; t<len; t++)
+			IP_boxStep<T>(acc, n, X(t), X(t-ww), false, ww, Y(t-r));
+
+		// window falls off the trailing end
+		for(int i=0; i<r; i++)
+			IP_boxStep<T>(acc, n, (T *) 0, X(len-ww+i), false,
+				      2*r-i, Y(len-r+i));
+	} else {
+		// even width 2m: half-weight end samples
+		int m = ww / 2;
+		for(int t=0; t<m; t++)
+			IP_boxStep<T>(acc, n, X(t), 0, false, 1, (T *) 0);
+		for(int k=0; k<m; k++)
+			IP_boxStep<T>(acc, n, X(m+k), 0, true, 2*m+1+2*k, Y(k));
+
+		// window totally fits
+		for(int t=ww; t<len; t++)
+			IP_boxStep<T>(acc, n, X(t), X(t-ww), true, 2*ww, Y(t-m));
+
+		// window falls off the trailing end
+		for(int i=0; i<m; i++)
+			IP_boxStep<T>(acc, n, (T *) 0, X(len-ww+i), true,
+				      2*ww-1-2*i, Y(len-m+i));
+	}
+}
+
+//@}
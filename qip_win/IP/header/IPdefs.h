@@ -191,6 +191,27 @@ enum dither_options {
 
 
 
+// ----------------------------------------------------------------------
+// error diffusion engines (IP_ditherDiffuseMT)
+//
+enum diffuse_engines {
+	DIFFUSE_EXACT,		// IP_ditherDiffuse() arithmetic, wavefront parallel
+	DIFFUSE_FIXED		// 16-bit fixed-point errors, ring buffer, serial
+};
+
+
+
+// ----------------------------------------------------------------------
+// error diffusion scan orders (IP_ditherDiffuseMT)
+//
+enum diffuse_scans {
+	DIFFUSE_LIBRARY,	// that of IP_ditherDiffuse(): IP::Serpentine
+	DIFFUSE_RASTER,		// every row left to right; wavefront parallel
+	DIFFUSE_SERPENTINE	// odd rows right to left; serial
+};
+
+
+
 // ----------------------------------------------------------------------
 // correlation options
 //
@@ -0,0 +1,666 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPdiffuse.tpp - Multithreaded error diffusion.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPdiffuse.tpp
+//! \brief	Multithreaded error diffusion.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_copyHeader(ImagePtr, int, ImagePtr);
+
+//! \addtogroup dither
+//@{
+
+// ----------------------------------------------------------------------
+// error diffusion kernels:
+// each tap sends wt/den of the error of the current pixel to the pixel
+// dy rows below and dx columns to the right of it
+//
+struct DiffuseTap {
+	int	dy, dx, wt;
+};
+
+struct DiffuseKernel {
+	int		 den;		// sum of weights
+	int		 ntaps;		// number of taps
+	const DiffuseTap *taps;		// taps in raster order
+};
+
+// ----------------------------------------------------------------------
+// error diffusion tables, in the arithmetic of IP_ditherDiffuse():
+// a pixel holds its input plus the errors diffused into it so far (v).
+// It is output as 0 if v < MXGRAY/2 and as MaxGray otherwise, and each
+// tap adds (int) (wt/den * (v - output)) to its pixel, truncated as the
+// library does. Tables are indexed by v + DIFFUSE_BIAS.
+//
+#define DIFFUSE_BIAS	(MXGRAY/2)
+#define DIFFUSE_RANGE	(2*MXGRAY)
+
+struct DiffuseTables {
+	int	     R, D;			// kernel half-width, depth
+	uchar	     out[DIFFUSE_RANGE];	// output of v
+	const short *tap[32];			// error sent by tap t
+	short	     err[32][DIFFUSE_RANGE];	// one table per distinct weight
+};
+
+// number of pixels a row publishes its progress in
+#define DIFFUSE_CHUNK	16
+
+// fractional bits of fixed-point pixel errors and of kernel weights
+#define DIFFUSE_FRAC	4
+#define DIFFUSE_WBITS	12
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_diffuseKernel:
+//
+// Return the fixed error diffusion kernel of method (dither_options),
+// or NULL for methods without a fixed kernel (OSTROMOUKHOV, USER_SPECIFIED).
+//! \brief	Fixed error diffusion kernel of a dither method.
+//! \param[in]	method - Error diffusion method (dither_options).
+//! \return	Pointer to static kernel, or NULL if none.
+//
+inline const DiffuseKernel *
+IP_diffuseKernel(int method)
+{
+	static const DiffuseTap fs[] = {
+				{0, 1, 7},
+		{1,-1, 3}, {1, 0, 5}, {1, 1, 1}
+	};
+	static const DiffuseTap jjn[] = {
+					      {0, 1, 7}, {0, 2, 5},
+		{1,-2, 3}, {1,-1, 5}, {1, 0, 7}, {1, 1, 5}, {1, 2, 3},
+		{2,-2, 1}, {2,-1, 3}, {2, 0, 5}, {2, 1, 3}, {2, 2, 1}
+	};
+	static const DiffuseTap fan[] = {
+						   {0, 1, 7},
+		{1,-2, 1}, {1,-1, 3}, {1, 0, 5}
+	};
+	static const DiffuseTap stucki[] = {
+					      {0, 1, 8}, {0, 2, 4},
+		{1,-2, 2}, {1,-1, 4}, {1, 0, 8}, {1, 1, 4}, {1, 2, 2},
+		{2,-2, 1}, {2,-1, 2}, {2, 0, 4}, {2, 1, 2}, {2, 2, 1}
+	};
+	static const DiffuseTap burkes[] = {
+					      {0, 1, 8}, {0, 2, 4},
+		{1,-2, 2}, {1,-1, 4}, {1, 0, 8}, {1, 1, 4}, {1, 2, 2}
+	};
+	static const DiffuseTap sierra[] = {
+					      {0, 1, 5}, {0, 2, 3},
+		{1,-2, 2}, {1,-1, 4}, {1, 0, 5}, {1, 1, 4}, {1, 2, 2},
+			   {2,-1, 2}, {2, 0, 3}, {2, 1, 2}
+	};
+	static const DiffuseTap sa[] = {
+								  {0, 2,32},
+		{1,-3,12},	      {1,-1,26},	    {1, 1,30},		  {1, 3,16},
+			   {2,-2,12},		 {2, 0,26},		 {2, 2,12},
+		{3,-3, 5},	      {3,-1,12},	    {3, 1,12},		  {3, 3, 5}
+	};
+	static const DiffuseKernel kernel[] = {
+		{ 16,  4, fs	 },
+		{ 48, 12, jjn	 },
+		{ 16,  4, fan	 },
+		{ 42, 12, stucki },
+		{ 32,  7, burkes },
+		{ 32, 10, sierra },
+		{200, 12, sa	 }
+	};
+
+	switch(method) {
+	case FLOYD_STEINBERG:	  return &kernel[0];
+	case JARVIS_JUDICE_NINKE: return &kernel[1];
+	case FAN:		  return &kernel[2];
+	case STUCKI:		  return &kernel[3];
+	case BURKES:		  return &kernel[4];
+	case SIERRA:		  return &kernel[5];
+	case STEVENSON_ARCE:	  return &kernel[6];
+	}
+	return NULL;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_diffuseTables:
+//
+// Build the error diffusion tables of kernel k (see DiffuseTables).
+// The weights are computed in double as wt/den, which reproduces the
+// constants of IP_ditherDiffuse() for every fixed kernel.
+//! \brief	Error diffusion tables of a kernel.
+//! \param[in]	k  - Error diffusion kernel.
+//! \param[out]	tb - Tables.
+//
+inline void
+IP_diffuseTables(const DiffuseKernel *k, DiffuseTables &tb)
+{
+	for(int i=0; i<DIFFUSE_RANGE; ++i)
+		tb.out[i] = (i-DIFFUSE_BIAS < MXGRAY/2) ? 0 : MaxGray;
+
+	tb.R = tb.D = 0;
+	int n = 0;
+	for(int t=0; t<k->ntaps; ++t) {
+		tb.R = MAX(tb.R, ABS(k->taps[t].dx));
+		tb.D = MAX(tb.D, k->taps[t].dy);
+
+		// taps of equal weight share a table
+		int s = 0;
+		while(k->taps[s].wt != k->taps[t].wt) ++s;
+		if(s < t) {
+			tb.tap[t] = tb.tap[s];
+			continue;
+		}
+		double c = (double) k->taps[t].wt / k->den;
+		short *e = tb.err[n++];
+		for(int i=0; i<DIFFUSE_RANGE; ++i)
+			e[i] = (short) (int) (c * (i-DIFFUSE_BIAS - tb.out[i]));
+		tb.tap[t] = e;
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_diffuseSpan:
+//
+// Error diffuse n pixels of a row, starting at column x and stepping by
+// dx (1 or -1), in the arithmetic of DiffuseTables. Tap t adds to the
+// error at offset off[t] from the pixel in e. N is the number of taps,
+// a template parameter so that the tap loop is unrolled; N = 0 takes it
+// from ntaps. Return the number of black output pixels.
+//! \brief	Error diffuse part of a row (library arithmetic).
+//! \param[in]	in    - Input row.
+//! \param[in]	lut   - Gamma correction of input pixels.
+//! \param[in]	e     - Error row of the input row.
+//! \param[in]	off   - Tap offsets in the error buffer.
+//! \param[in]	tb    - Error diffusion tables.
+//! \param[in]	ntaps - Number of taps (used when N is 0).
+//! \param[in]	x     - First column.
+//! \param[in]	n     - Number of pixels.
+//! \param[in]	dx    - Column step (1 or -1).
+//! \param[out]	out   - Output row.
+//! \return	Number of black output pixels.
+//
+template<int N>
+inline int
+IP_diffuseSpan(const uchar *in, const uchar *lut, short *e, const int *off,
+	       const DiffuseTables &tb, int ntaps, int x, int n, int dx,
+	       uchar *out)
+{
+	// local copies: stores to out may alias the tables
+	int nt = N ? N : ntaps;
+	const short *tap[32];
+	int	     o[32];
+	for(int t=0; t<nt; ++t) {
+		tap[t] = tb.tap[t];
+		o[t]   = off[t];
+	}
+
+	int black = 0;
+	for(; n>0; --n, x+=dx) {
+		int   v = lut[in[x]] + e[x] + DIFFUSE_BIAS;
+		uchar p = tb.out[v];
+		for(int t=0; t<nt; ++t)
+			e[x + o[t]] += tap[t][v];
+		out[x] = p;
+		black += !p;
+	}
+	return black;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_diffuseSerpentine:
+//
+// Return true if scan order scan (diffuse_scans) reverses odd rows.
+// DIFFUSE_LIBRARY follows IP::Serpentine, as IP_ditherDiffuse() does.
+//
+inline bool
+IP_diffuseSerpentine(int scan)
+{
+	if(scan == DIFFUSE_LIBRARY) return (IP::Serpentine != 0);
+	return (scan == DIFFUSE_SERPENTINE);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_diffuseChannel:
+//
+// Error diffuse one uchar channel in the arithmetic of IP_ditherDiffuse()
+// (see DiffuseTables), so that both produce the same output. If scan
+// (diffuse_scans) is serpentine, odd rows are scanned right to left with
+// the kernel mirrored, as in the library.
+// Rows scanned left to right run on a skewed wavefront: row y runs in
+// parallel with row y-1 once row y-1 is lead pixels ahead, where
+// lead = 2*R+1 and R is the kernel half-width, so that the taps of the
+// two rows never reach the same pixel. A right-to-left row needs all of
+// the row above it, so serpentine scans run serially.
+// Input and output may be the same buffer. If rows is given, rows[y]
+// is set to the number of black (0) output pixels in row y, counted as
+// the pixels are produced. Return the number of black output pixels.
+//! \brief	Error diffuse one uchar channel (wavefront parallel).
+//! \param[in]	src	- Input pixels (w*h).
+//! \param[in]	w	- Width.
+//! \param[in]	h	- Height.
+//! \param[in]	lut	- Gamma correction of input pixels (MXGRAY entries).
+//! \param[in]	k	- Error diffusion kernel.
+//! \param[out]	dst	- Output pixels (0 or MaxGray).
+//! \param[in]	threads	- Thread count; 1 for serial scan, 0 for all cores.
+//! \param[out]	rows	- Black pixels per row (h entries), or NULL.
+//! \param[in]	scan	- Scan order (diffuse_scans).
+//! \return	Number of black output pixels.
+//
+inline int
+IP_diffuseChannel(const uchar *src, int w, int h, const uchar *lut,
+		  const DiffuseKernel *k, uchar *dst, int threads = 0,
+		  int *rows = NULL, int scan = DIFFUSE_LIBRARY)
+{
+	DiffuseTables tb;
+	IP_diffuseTables(k, tb);
+	int R = tb.R;
+
+	// error buffer with R guard columns on either side and D guard rows;
+	// errors sent past the borders are dropped, as in the library
+	int ew = w + 2*R;
+	std::vector<short> err((size_t) ew * (h+tb.D), 0);
+
+	// tap offsets of left-to-right and of right-to-left rows
+	int off[2][32];
+	for(int t=0; t<k->ntaps; ++t) {
+		off[0][t] = k->taps[t].dy*ew + k->taps[t].dx;
+		off[1][t] = k->taps[t].dy*ew - k->taps[t].dx;
+	}
+	bool serpentine = IP_diffuseSerpentine(scan);
+
+	// per-row progress (number of finished pixels), one cache line each
+	struct Progress {
+		std::atomic<int> done;
+		char		 pad[64 - sizeof(std::atomic<int>)];
+	};
+	threads = MIN(IP_threadCount(threads), h);
+	bool par = (threads > 1 && !serpentine);
+	if(!par) threads = 1;
+	std::vector<Progress> progress(par ? h : 0);
+	for(int y=0; y<(int) progress.size(); ++y)
+		progress[y].done.store(0);
+
+	// black pixels per row; each row is written by one thread only
+	std::vector<int> counts(rows ? 0 : h);
+	if(!rows) rows = counts.data();
+
+	int lead = 2*R + 1;
+	auto row = [&](int y) {
+		const uchar *in  = src + (size_t) y*w;
+		uchar	    *out = dst + (size_t) y*w;
+		short	    *e   = &err[(size_t) y*ew + R];
+		bool	     rev = serpentine && (y & 1);
+		int ready = (par && y) ? 0 : w;	// finished pixels of row y-1
+		int black = 0;
+
+		for(int n=0; n<w; n+=DIFFUSE_CHUNK) {
+			int m = MIN(DIFFUSE_CHUNK, w-n);
+			int x = rev ? w-1-n : n;
+
+			// wait for row y-1 to be lead pixels past this chunk
+			int need = MIN(n+m-1+lead, w);
+			while(ready < need)
+				if((ready = progress[y-1].done.load(
+					std::memory_order_acquire)) < need)
+					std::this_thread::yield();
+
+			const int *o = off[rev];
+			int dx = rev ? -1 : 1;
+			switch(k->ntaps) {
+			case  4: black += IP_diffuseSpan< 4>(in, lut, e, o, tb, 4,
+							    x, m, dx, out); break;
+			case  7: black += IP_diffuseSpan< 7>(in, lut, e, o, tb, 7,
+							    x, m, dx, out); break;
+			case 10: black += IP_diffuseSpan<10>(in, lut, e, o, tb, 10,
+							    x, m, dx, out); break;
+			case 12: black += IP_diffuseSpan<12>(in, lut, e, o, tb, 12,
+							    x, m, dx, out); break;
+			default: black += IP_diffuseSpan< 0>(in, lut, e, o, tb,
+							    k->ntaps, x, m, dx, out);
+			}
+			if(par)
+				progress[y].done.store(n+m, std::memory_order_release);
+		}
+		rows[y] = black;
+	};
+	IP_parallelFor(h, row, threads);
+
+	int total = 0;
+	for(int y=0; y<h; ++y) total += rows[y];
+	return total;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_diffuseLut:
+//
+// Build gamma correction luts for error diffusion. lut is that of
+// IP_gammaCorrect(), which IP_ditherDiffuse() applies first: gamma <= 0
+// is taken as 0.1, gamma = 1 leaves pixels unchanged, and otherwise v
+// maps to MaxGray*(v/MaxGray)^(1/gamma), truncated. lutFixed holds the
+// same curve unrounded, in fixed point with DIFFUSE_FRAC fractional bits.
+//! \brief	Gamma correction luts for error diffusion.
+//! \param[in]	gamma	 - Gamma correction.
+//! \param[out]	lut	 - Lut of IP_gammaCorrect() (MXGRAY entries).
+//! \param[out]	lutFixed - Fixed-point lut (MXGRAY entries).
+//
+inline void
+IP_diffuseLut(double gamma, uchar *lut, short *lutFixed)
+{
+	if(gamma <= 0) gamma = .1;
+	for(int i=0; i<MXGRAY; ++i) {
+		double v = MaxGray * pow((double) i/MaxGray, 1./gamma);
+		lut[i]	    = (gamma == 1) ? i : (uchar) (int) v;
+		lutFixed[i] = (short) ROUND(v * (1 << DIFFUSE_FRAC));
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DiffuseRows class declaration
+//! \brief	Row-at-a-time error diffusion.
+//! \details	Error diffuses an image that is fed to it one row at a
+//!		time, top to bottom. Only the D+1 error rows the kernel
+//!		reaches are kept, in a ring of (D+1)*(w+2R) 16-bit errors
+//!		that stays cache resident for any image height.
+//!		With DIFFUSE_EXACT rows are diffused by IP_diffuseSpan(), as
+//!		in IP_diffuseChannel(), serpentine scan included, so the
+//!		output is that of IP_ditherDiffuse().
+//!		With DIFFUSE_FIXED rows are scanned left to right, errors
+//!		carry DIFFUSE_FRAC fractional bits, and tap weights are
+//!		applied as integer multiply-shifts whose rounding remainder
+//!		goes to the first tap, so that no error is lost.
+//
+class DiffuseRows {
+public:
+	DiffuseRows(const DiffuseKernel *k, int w, double gamma,
+		    int engine = DIFFUSE_EXACT, int scan = DIFFUSE_LIBRARY);
+
+	int	next(const uchar *in, uchar *out);	// diffuse next row
+
+private:
+	template<int N>
+	int	diffuseFixed(const uchar *, const short *, short **, uchar *);
+
+	const DiffuseKernel *m_kernel;
+	int		 m_width;
+	int		 m_engine;
+	int		 m_R, m_D;		// kernel half-width, depth
+	int		 m_y;			// index of next row
+	bool		 m_serpentine;		// DIFFUSE_EXACT: reverse odd rows
+	int		 m_wtFixed[32];		// fixed-point tap weights
+	uchar		 m_lut	  [MXGRAY];	// gamma lut of IP_gammaCorrect()
+	short		 m_lutFixed[MXGRAY];	// fixed-point gamma lut
+	DiffuseTables	 m_tables;		// DIFFUSE_EXACT tables
+	std::vector<short> m_err;		// error ring
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DiffuseRows::DiffuseRows:
+//
+// Constructor for rows of width w, kernel k, gamma correction gamma,
+// engine (diffuse_engines) and scan order (diffuse_scans). DIFFUSE_FIXED
+// always scans left to right; DIFFUSE_LIBRARY reads IP::Serpentine here.
+//! \brief	Constructor.
+//! \param[in]	k	- Error diffusion kernel.
+//! \param[in]	w	- Row width.
+//! \param[in]	gamma	- Gamma correction applied before dithering.
+//! \param[in]	engine	- DIFFUSE_EXACT or DIFFUSE_FIXED.
+//! \param[in]	scan	- Scan order (diffuse_scans).
+//
+inline
+DiffuseRows::DiffuseRows(const DiffuseKernel *k, int w, double gamma,
+			 int engine, int scan)
+	: m_kernel(k),
+	  m_width (w),
+	  m_engine(engine),
+	  m_y	  (0),
+	  m_serpentine(engine == DIFFUSE_EXACT && IP_diffuseSerpentine(scan))
+{
+	IP_diffuseTables(k, m_tables);
+	m_R = m_tables.R;
+	m_D = m_tables.D;
+	for(int t=0; t<k->ntaps; ++t)
+		m_wtFixed[t] = ((k->taps[t].wt << DIFFUSE_WBITS) + k->den/2)
+				/ k->den;
+	IP_diffuseLut(gamma, m_lut, m_lutFixed);
+	m_err.assign((size_t) (w + 2*m_R) * (m_D + 1), 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DiffuseRows::next:
+//
+// Error diffuse the next row: in -> out (0 or MaxGray).
+// in and out may be the same buffer.
+// Return the number of black (0) pixels in out.
+//! \brief	Error diffuse the next row.
+//! \param[in]	in  - Input row.
+//! \param[out]	out - Output row.
+//! \return	Number of black output pixels.
+//
+inline int
+DiffuseRows::next(const uchar *in, uchar *out)
+{
+	const DiffuseKernel *k = m_kernel;
+	int  ew    = m_width + 2*m_R;
+	int  nrow  = m_D + 1;
+	int  cur   = m_y % nrow;
+	bool rev   = m_serpentine && (m_y & 1);
+	int  black = 0;
+
+	// point each tap into its error row (rows y..y+D of the ring),
+	// mirrored for right-to-left rows
+	short *tap[32];
+	for(int t=0; t<k->ntaps; ++t) {
+		int dx = rev ? -k->taps[t].dx : k->taps[t].dx;
+		tap[t] = &m_err[(size_t) ((m_y+k->taps[t].dy) % nrow) * ew
+			 + m_R] + dx;
+	}
+	short *e = &m_err[(size_t) cur*ew + m_R];
+
+	if(m_engine == DIFFUSE_FIXED) {
+		switch(k->ntaps) {
+		case  4: black = diffuseFixed< 4>(in, e, tap, out); break;
+		case  7: black = diffuseFixed< 7>(in, e, tap, out); break;
+		case 10: black = diffuseFixed<10>(in, e, tap, out); break;
+		case 12: black = diffuseFixed<12>(in, e, tap, out); break;
+		}
+	} else {
+		int off[32];
+		for(int t=0; t<k->ntaps; ++t)
+			off[t] = (int) (tap[t] - e);
+		int x  = rev ? m_width-1 : 0;
+		int dx = rev ? -1 : 1;
+		const DiffuseTables &tb = m_tables;
+		switch(k->ntaps) {
+		case  4: black = IP_diffuseSpan< 4>(in, m_lut, e, off, tb, 4,
+						    x, m_width, dx, out); break;
+		case  7: black = IP_diffuseSpan< 7>(in, m_lut, e, off, tb, 7,
+						    x, m_width, dx, out); break;
+		case 10: black = IP_diffuseSpan<10>(in, m_lut, e, off, tb, 10,
+						    x, m_width, dx, out); break;
+		case 12: black = IP_diffuseSpan<12>(in, m_lut, e, off, tb, 12,
+						    x, m_width, dx, out); break;
+		default: black = IP_diffuseSpan< 0>(in, m_lut, e, off, tb,
+						    k->ntaps, x, m_width, dx,
+						    out);
+		}
+	}
+
+	// row y becomes row y+D+1: clear it, guard columns included
+	memset(e - m_R, 0, ew * sizeof(short));
+	m_y++;
+	return black;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// DiffuseRows::diffuseFixed:
+//
+// Error diffuse one row with N taps and 16-bit fixed-point errors.
+//! \brief	Error diffuse one row (fixed-point errors).
+//! \param[in]	in  - Input row.
+//! \param[in]	e   - Error row of the input row.
+//! \param[in]	tap - Error row pointers, offset by the tap column.
+//! \param[out]	out - Output row.
+//! \return	Number of black output pixels.
+//
+template<int N>
+inline int
+DiffuseRows::diffuseFixed(const uchar *in, const short *e, short **tap,
+			  uchar *out)
+{
+	const int one  = 1 << DIFFUSE_FRAC;
+	const int thr  = (MXGRAY/2) << DIFFUSE_FRAC;
+	const int half = 1 << (DIFFUSE_WBITS-1);
+	int black = 0;
+	for(int x=0; x<m_width; ++x) {
+		int v = m_lutFixed[in[x]] + e[x];
+		int o = (v < thr) ? 0 : MXGRAY-1;
+		int d = v - o*one;
+
+		// spread error; remainder of rounding goes to first tap
+		int rest = d;
+		for(int t=1; t<N; ++t) {
+			int c = (d*m_wtFixed[t] + half) >> DIFFUSE_WBITS;
+			tap[t][x] += c;
+			rest -= c;
+		}
+		tap[0][x] += rest;
+		out[x] = o;
+		black += !o;
+	}
+	return black;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_countDiffuseRows:
+//
+// Count black (0) pixels of uchar channel 0 of I, per row into rows (if
+// given). Return the total. Used for output that was not dithered here.
+//
+inline int
+IP_countDiffuseRows(const ImagePtr &I, int *rows)
+{
+	if(I->channelType(0) != UCHAR_TYPE) return 0;
+
+	int w = I->width ();
+	int h = I->height();
+	ChannelPtr<uchar> p = (*I)[0];
+	const uchar *in = p.buf();
+	int total = 0;
+	for(int y=0; y<h; ++y, in+=w) {
+		int black = 0;
+		for(int x=0; x<w; ++x) black += !in[x];
+		if(rows) rows[y] = black;
+		total += black;
+	}
+	return total;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_ditherDiffuseMT:
+//
+// Multithreaded IP_ditherDiffuse(): error diffuse I1 into I2 using method
+// (dither_options) after gamma correcting I1 by gamma. The DIFFUSE_EXACT
+// engine produces the output of IP_ditherDiffuse() for every thread
+// count, with odd rows reversed if scan (diffuse_scans) is serpentine.
+// Raster scans (DIFFUSE_RASTER, or DIFFUSE_LIBRARY with IP::Serpentine
+// clear) with more than one thread have their rows scheduled on a skewed
+// wavefront over threads threads (0 for all cores) by
+// IP_diffuseChannel(). Serpentine rows cannot overlap; serpentine is the
+// library default, so callers that want the parallel scan must ask for
+// DIFFUSE_RASTER; other scans run serially in IP_diffuseChannel().
+// The DIFFUSE_FIXED engine is serial, keeps only a few rows of
+// fixed-point errors, and approximates the library output. Methods
+// without a fixed kernel and non-uchar channels are passed on to
+// IP_ditherDiffuse(), which scans in its own order.
+// Black (0) pixels of channel 0 are counted: if rows is given, rows[y]
+// is set to the count of row y, and the total is returned. The engines
+// here count pixels as they are produced, which saves a pass over the
+// output; only output of IP_ditherDiffuse() is counted afterwards.
+//! \brief	Multithreaded error diffusion.
+//! \param[in]	I1	- Input image.
+//! \param[in]	method	- Error diffusion method (dither_options).
+//! \param[in]	gamma	- Gamma correction applied before dithering.
+//! \param[out]	I2	- Output image.
+//! \param[in]	threads	- Thread count; 1 for serial scan, 0 for all cores.
+//! \param[in]	engine	- DIFFUSE_EXACT or DIFFUSE_FIXED (diffuse_engines).
+//! \param[out]	rows	- Black pixels per row of channel 0, or NULL.
+//! \param[in]	scan	- Scan order (diffuse_scans).
+//! \return	Number of black pixels in channel 0.
+//
+inline int
+IP_ditherDiffuseMT(const ImagePtr &I1, int method, double gamma,
+		   const ImagePtr &I2,
+		   int threads = 0, int engine = DIFFUSE_EXACT,
+		   int *rows = NULL, int scan = DIFFUSE_LIBRARY)
+{
+	int w = I1->width();
+	int h = I1->height();
+
+	// the library handles unsupported input
+	const DiffuseKernel *k = IP_diffuseKernel(method);
+	int nch = I1->maxChannel();
+	for(int ch=0; k && ch<nch; ++ch)
+		if(I1->channelType(ch) != UCHAR_TYPE) k = NULL;
+	if(!k) {
+		IP_ditherDiffuse(I1, method, gamma, I2);
+		return IP_countDiffuseRows(I2, rows);
+	}
+
+	// gamma correction lut
+	uchar lut[MXGRAY];
+	short lutFixed[MXGRAY];
+	IP_diffuseLut(gamma, lut, lutFixed);
+
+	if(I1 != I2) IP_copyImageHeader(I1, I2);
+
+	// count channel 0 only
+	int total = 0;
+	ChannelPtr<uchar> p1, p2;
+	for(int ch=0; ch<nch; ++ch) {
+		p1 = (*I1)[ch];
+		p2 = (*I2)[ch];
+		int *r = ch ? NULL : rows;
+		int  n = 0;
+		if(engine == DIFFUSE_FIXED) {
+			DiffuseRows dr(k, w, gamma, DIFFUSE_FIXED);
+			for(int y=0; y<h; ++y) {
+				int b = dr.next(p1.buf() + (size_t) y*w,
+						p2.buf() + (size_t) y*w);
+				if(r) r[y] = b;
+				n += b;
+			}
+		} else	n = IP_diffuseChannel(p1.buf(), w, h, lut, k, p2.buf(),
+					      threads, r, scan);
+		if(!ch) total = n;
+	}
+	return total;
+}
+
+//@}
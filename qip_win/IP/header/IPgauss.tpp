@@ -0,0 +1,243 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPgauss.tpp - Recursive (IIR) Gaussian blur.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPgauss.tpp
+//! \brief	Recursive (IIR) Gaussian blur.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_blurGaussian(ImagePtr, double, ImagePtr);
+extern void IP_copyHeader  (ImagePtr, int, ImagePtr);
+
+//! \addtogroup filtnbr
+//@{
+
+// ----------------------------------------------------------------------
+// Coefficients of the Young-van Vliet recursive Gaussian: a causal pass
+//	w[t] = B*x[t] + a[0]*w[t-1] + a[1]*w[t-2] + a[2]*w[t-3]
+// followed by the same filter run backwards over w. The cost per sample
+// is independent of sigma. Samples beyond either end of a scanline are
+// taken to replicate the end samples, as IP_blurGaussian() pads its
+// input: the causal pass starts in the steady state of the first
+// sample, and M gives the exact start of the backward pass from the
+// last three values of w (Triggs and Sdika, 2006).
+//
+struct GaussIIR {
+	double	B;		// input gain
+	double	a[3];		// feedback coefficients
+	double	M[3][3];	// backward start from w[len-1..len-3]
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_gaussIIRCoeffs:
+//
+// g <- Young-van Vliet coefficients for standard deviation sigma >= 0.5.
+// M is found by running the homogeneous recursions on the deviation of
+// w from the replicated end sample until they die out; that takes time
+// proportional to sigma once per call, not per sample.
+//! \brief	Coefficients of recursive Gaussian.
+//! \param[in]	sigma - Standard deviation of the Gaussian.
+//! \param[out]	g     - Filter coefficients.
+//
+inline void
+IP_gaussIIRCoeffs(double sigma, GaussIIR &g)
+{
+	double q = (sigma >= 2.5) ? 0.98711*sigma - 0.96330
+				  : 3.97156 - 4.14554*sqrt(1 - 0.26891*sigma);
+	double q2 = q * q;
+	double q3 = q * q2;
+	double b0 = 1.57825 + 2.44413*q + 1.4281*q2 + 0.422205*q3;
+	g.a[0] = (2.44413*q + 2.85619*q2 + 1.26661*q3) / b0;
+	g.a[1] = -(1.4281*q2 + 1.26661*q3) / b0;
+	g.a[2] = 0.422205*q3 / b0;
+	g.B    = 1 - (g.a[0] + g.a[1] + g.a[2]);
+
+	// column k of M: backward start for a unit deviation of w[len-1-k]
+	int len = (int) (20*sigma) + 64;
+	std::vector<double> d;
+	for(int k=0; k<3; k++) {
+		d.assign(len + 3, 0.);
+		d[2-k] = 1;				// d[0..2]: w[len-3..len-1]
+		for(int t=3; t<len+3; t++)
+			d[t] = g.a[0]*d[t-1] + g.a[1]*d[t-2] + g.a[2]*d[t-3];
+		double y[3] = {0, 0, 0};		// y[t+1], y[t+2], y[t+3]
+		for(int t=len+2; t>=3; t--) {
+			double v = g.B*d[t] + g.a[0]*y[0] + g.a[1]*y[1] +
+				   g.a[2]*y[2];
+			y[2] = y[1];
+			y[1] = y[0];
+			y[0] = v;
+		}
+		for(int i=0; i<3; i++) g.M[i][k] = y[i];
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_gaussLanes:
+//
+// dst <- Recursive Gaussian blur of n lanes of len samples, laid out as
+// in IP_boxLanes(): sample t of lane j is src[t*sstride + j] and
+// dst[t*dstride + j]. Each step of a pass updates all lanes in a loop
+// the compiler vectorizes. The passes run in double: at large sigma the
+// poles approach 1 and float sums drift by a gray level. All of src is
+// read before dst is written, so src and dst may be the same.
+//! \brief	Recursive Gaussian over parallel lanes.
+//! \param[in]	src	- Input samples.
+//! \param[in]	sstride	- Distance between samples t and t+1 of src.
+//! \param[in]	len	- Number of samples per lane.
+//! \param[in]	n	- Number of lanes.
+//! \param[in]	g	- Filter coefficients.
+//! \param[out]	dst	- Output samples.
+//! \param[in]	dstride	- Distance between samples t and t+1 of dst.
+//
+inline void
+IP_gaussLanes(const uchar *src, int sstride, int len, int n,
+	      const GaussIIR &g, uchar *dst, int dstride)
+{
+	const double B  = g.B;
+	const double a0 = g.a[0];
+	const double a1 = g.a[1];
+	const double a2 = g.a[2];
+	const double hi = MaxGray;
+
+	// w holds len rows of the causal pass and 3 rows past the end
+	ScratchScope scratch;
+	double *w  = scratch.alloc<double>((size_t) (len+3) * n);
+	double *x0 = scratch.alloc<double>(n);	// first sample, replicated
+	for(int j=0; j<n; j++) x0[j] = src[j];
+	auto W = [&](int t) { return t >= 0 ? w + (size_t) t * n : x0; };
+
+	// causal pass
+	for(int t=0; t<len; t++) {
+		const uchar  *x  = src + (size_t) t * sstride;
+		const double *w1 = W(t-1);
+		const double *w2 = W(t-2);
+		const double *w3 = W(t-3);
+		double	     *wt = W(t);
+		for(int j=0; j<n; j++)
+			wt[j] = B*x[j] + a0*w1[j] + a1*w2[j] + a2*w3[j];
+	}
+
+	// start of the backward pass, from the replicated last sample u
+	const uchar *xl = src + (size_t) (len-1) * sstride;
+	for(int j=0; j<n; j++) {
+		double u = xl[j];
+		double e[3];
+		for(int k=0; k<3; k++) e[k] = W(len-1-k)[j] - u;
+		for(int i=0; i<3; i++)
+			W(len+i)[j] = u + g.M[i][0]*e[0] + g.M[i][1]*e[1] +
+					  g.M[i][2]*e[2];
+	}
+
+	// backward pass, in place over w
+	for(int t=len-1; t>=0; t--) {
+		double	     *wt = W(t);
+		const double *y1 = W(t+1);
+		const double *y2 = W(t+2);
+		const double *y3 = W(t+3);
+		uchar	     *y  = dst + (size_t) t * dstride;
+		for(int j=0; j<n; j++) {
+			double v = B*wt[j] + a0*y1[j] + a1*y2[j] + a2*y3[j];
+			wt[j] = v;
+			v = (v < 0) ? 0 : (v > hi) ? hi : v;
+			y[j] = (uchar) (int) (v + .5);
+		}
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurGaussianIIR:
+//
+// I2 <- Blur I1 with a Gaussian of standard deviation sigma, using the
+// recursive filter of IP_gaussLanes(). The cost is independent of
+// sigma, where IP_blurGaussian() convolves with a kernel of 5*sigma
+// taps. sigma <= 0 selects the sigma that IP_blurGaussian() derives
+// from a kernel size of -sigma. Rows are blurred in transposed bands of
+// BLUR_BAND rows and columns in strips of BLUR_STRIP columns, spread
+// over threads threads. The recursive filter approximates the full
+// Gaussian, and IP_blurGaussian() a truncated one, so results differ
+// by a few gray levels at most.
+// Images with channels other than uchar, and sigma below 3, where the
+// recursive filter loses accuracy and the kernel of IP_blurGaussian()
+// is short anyway, are passed on to IP_blurGaussian() with sigma as
+// given.
+// I1 and I2 may be the same image.
+//! \brief	Recursive Gaussian blur.
+//! \param[in]	I1	- Input image.
+//! \param[in]	sigma	- Standard deviation (<= 0: -kernel size).
+//! \param[out]	I2	- Output image.
+//! \param[in]	threads	- Thread count; 0 selects all cores.
+//
+inline void
+IP_blurGaussianIIR(const ImagePtr &I1, double sigma, const ImagePtr &I2,
+		   int threads = 0)
+{
+	// standard deviation; the library gets sigma as given
+	double sd = sigma;
+	if(sigma <= 0) {
+		int sz = (int) -sigma;
+		if(sz % 2 == 0) sz++;
+		sd = sz / 5.;
+	}
+	bool ok = (sd >= 3);
+	for(int ch=0; ok && ch<I1->maxChannel(); ch++)
+		ok = (I1->channelType(ch) == UCHAR_TYPE);
+	if(!ok) {
+		IP_blurGaussian(I1, sigma, I2);
+		return;
+	}
+
+	GaussIIR g;
+	IP_gaussIIRCoeffs(sd, g);
+
+	int w = I1->width ();
+	int h = I1->height();
+	IP_copyHeader(I1, 1, I2);
+	for(int ch=0; ch<I1->maxChannel(); ch++) {
+		ChannelPtr<uchar> p1 = (*I1)[ch];
+		ChannelPtr<uchar> p2 = (*I2)[ch];
+		const uchar *s0 = p1.buf();
+		uchar	    *d0 = p2.buf();
+
+		// rows: transpose a band so that its rows become lanes
+		auto band = [&](int k) {
+			int y0 = k * BLUR_BAND;
+			int n  = MIN(BLUR_BAND, h - y0);
+			ScratchScope scratch;
+			uchar *buf = scratch.alloc<uchar>((size_t) w * n);
+			for(int j=0; j<n; j++) {
+				const uchar *s = s0 + (size_t) (y0+j) * w;
+				for(int x=0; x<w; x++) buf[(size_t) x*n + j] = s[x];
+			}
+			IP_gaussLanes(buf, n, w, n, g, buf, n);
+			for(int j=0; j<n; j++) {
+				uchar *d = d0 + (size_t) (y0+j) * w;
+				for(int x=0; x<w; x++) d[x] = buf[(size_t) x*n + j];
+			}
+		};
+		IP_parallelFor((h + BLUR_BAND - 1) / BLUR_BAND, band, threads);
+
+		// columns: the lanes of a strip are adjacent columns
+		auto strip = [&](int k) {
+			int x0 = k * BLUR_STRIP;
+			int n  = MIN(BLUR_STRIP, w - x0);
+			IP_gaussLanes(d0 + x0, w, h, n, g, d0 + x0, w);
+		};
+		IP_parallelFor((w + BLUR_STRIP - 1) / BLUR_STRIP, strip, threads);
+	}
+}
+
+//@}
@@ -0,0 +1,194 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPmedian.tpp - Constant-time median filter.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPmedian.tpp
+//! \brief	Constant-time median filter.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_median	 (ImagePtr, int, int, ImagePtr);
+extern void IP_copyHeader(ImagePtr, int, ImagePtr);
+
+//! \addtogroup filtnbr
+//@{
+
+// ----------------------------------------------------------------------
+// columns per stripe of IP_medianMT(); stripes are at least 2*sz wide
+// so that building the first window of a row stays a small share of
+// the row's work
+//
+enum { MEDIAN_STRIP = 256 };
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_medianStripe:
+//
+// dst <- Median filter of columns [x0,x1) of the w x h uchar channel src,
+// with a sz x sz window (sz odd, at most 255) and the output rule of
+// IP_median(): the median, or for avg > 0 the truncated mean of the
+// 2*avg+1 window values ranked around it. Pixels beyond the image edge
+// replicate the edge, as IP_median() pads its input.
+// This is the algorithm of Perreault and Hebert (2007): every column of
+// the stripe keeps a histogram of its sz pixels around the current row,
+// updated by one pixel out and one in per row, and the window
+// histogram slides along the row by adding one column histogram and
+// subtracting another. The ranks are found in a 16-bin coarse histogram
+// and then in 16 bins of the 256-bin fine one. The work per pixel does
+// not depend on sz.
+//
+inline void
+IP_medianStripe(const uchar *src, int w, int h, int x0, int x1, int sz,
+		int avg, uchar *dst)
+{
+	int k    = sz / 2;
+	int cols = x1 - x0 + 2*k;		// columns that feed the stripe
+	int mid  = sz * sz / 2;			// rank of the median
+	float scale = 1.0f / (float) (2*avg + 1);
+
+	ScratchScope scratch;
+	ushort *fine   = scratch.alloc<ushort>((size_t) cols * MXGRAY);
+	ushort *coarse = scratch.alloc<ushort>((size_t) cols * 16);
+	ushort *kf     = scratch.alloc<ushort>(MXGRAY);	// window histogram
+	ushort *kc     = scratch.alloc<ushort>(16);
+	int    *xs     = scratch.alloc<int>(cols);	// source column
+	memset(fine,   0, (size_t) cols * MXGRAY * sizeof(ushort));
+	memset(coarse, 0, (size_t) cols * 16	 * sizeof(ushort));
+	for(int c=0; c<cols; c++) xs[c] = CLIP(x0 - k + c, 0, w-1);
+
+	// column histograms of rows -k..k
+	for(int dy=-k; dy<=k; dy++) {
+		const uchar *row = src + (size_t) CLIP(dy, 0, h-1) * w;
+		for(int c=0; c<cols; c++) {
+			int v = row[xs[c]];
+			fine  [c*MXGRAY + v]++;
+			coarse[c*16 + (v>>4)]++;
+		}
+	}
+
+	for(int y=0; y<h; y++) {
+		// slide column histograms down: row y-k-1 out, row y+k in
+		if(y > 0) {
+			const uchar *out = src + (size_t) CLIP(y-k-1, 0, h-1) * w;
+			const uchar *in  = src + (size_t) CLIP(y+k,   0, h-1) * w;
+			for(int c=0; c<cols; c++) {
+				int v = out[xs[c]];
+				fine  [c*MXGRAY + v]--;
+				coarse[c*16 + (v>>4)]--;
+				v = in[xs[c]];
+				fine  [c*MXGRAY + v]++;
+				coarse[c*16 + (v>>4)]++;
+			}
+		}
+
+		// window histogram at x0: columns 0..2k
+		memset(kf, 0, MXGRAY * sizeof(ushort));
+		memset(kc, 0, 16     * sizeof(ushort));
+		for(int c=0; c<=2*k; c++) {
+			const ushort *f = fine   + c*MXGRAY;
+			const ushort *g = coarse + c*16;
+			for(int i=0; i<MXGRAY; i++) kf[i] += f[i];
+			for(int i=0; i<16;     i++) kc[i] += g[i];
+		}
+
+		uchar *d = dst + (size_t) y * w;
+		for(int x=x0; x<x1; x++) {
+			// slide window histogram right: column x-k-1 out, x+k in
+			if(x > x0) {
+				int c = x - x0 + 2*k;
+				const ushort *fa = fine   + c*MXGRAY;
+				const ushort *fs = fine   + (c-sz)*MXGRAY;
+				const ushort *ga = coarse + c*16;
+				const ushort *gs = coarse + (c-sz)*16;
+				for(int i=0; i<MXGRAY; i++) kf[i] += fa[i] - fs[i];
+				for(int i=0; i<16;     i++) kc[i] += ga[i] - gs[i];
+			}
+
+			// value v at rank mid-avg; r is its rank within bin v
+			int r = mid - avg;
+			int b = 0;
+			while(kc[b] <= r) r -= kc[b++];
+			int v = b * 16;
+			while(kf[v] <= r) r -= kf[v++];
+			if(!avg) {
+				d[x] = (uchar) v;
+				continue;
+			}
+
+			// sum the 2*avg+1 values from rank mid-avg up
+			int need = 2*avg + 1;
+			int take = MIN(kf[v] - r, need);
+			int sum  = take * v;
+			for(need-=take; need>0; need-=take) {
+				v++;
+				take = MIN(kf[v], need);
+				sum += take * v;
+			}
+			d[x] = (uchar) (int) ((float) sum * scale);
+		}
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_medianMT:
+//
+// I2 <- Median filter of I1 with a sz x sz window; if avg > 0, the mean
+// of the 2*avg+1 window values ranked around the median. Same result as
+// IP_median(), which sorts every window, but in time per pixel that is
+// independent of sz (see IP_medianStripe()). Stripes of at least
+// MEDIAN_STRIP columns are spread over threads threads.
+// Images with channels other than uchar, sz of 3 or less (where sorting
+// 9 values is faster than histogram upkeep), sz above 255 (whose window
+// counts overflow the 16-bit histograms) and negative avg are passed on
+// to IP_median(). I1 and I2 may be the same image.
+//! \brief	Constant-time median filter.
+//! \param[in]	I1	- Input image.
+//! \param[in]	sz	- Window width and height (made odd).
+//! \param[in]	avg	- Neighbors of the median to average on each side.
+//! \param[out]	I2	- Output image.
+//! \param[in]	threads	- Thread count; 0 selects all cores.
+//
+inline void
+IP_medianMT(const ImagePtr &I1, int sz, int avg, const ImagePtr &I2,
+	    int threads = 0)
+{
+	// window size and neighbors as IP_median() takes them
+	if(sz % 2 == 0) sz++;
+	bool ok = (sz > 3 && sz <= 255 && avg >= 0);
+	for(int ch=0; ok && ch<I1->maxChannel(); ch++)
+		ok = (I1->channelType(ch) == UCHAR_TYPE);
+	if(!ok) {
+		IP_median(I1, sz, avg, I2);
+		return;
+	}
+	avg = MIN(avg, sz*sz/2);
+
+	// in place: read from a copy of the input
+	ImagePtr I = IP_inPlaceSource(I1, I2);
+	if(I1 != I2) IP_copyHeader(I1, 1, I2);
+
+	int w  = I->width ();
+	int h  = I->height();
+	int sw = MAX((int) MEDIAN_STRIP, 2*sz);
+	for(int ch=0; ch<I->maxChannel(); ch++) {
+		ChannelPtr<uchar> p1 = (*I )[ch];
+		ChannelPtr<uchar> p2 = (*I2)[ch];
+		const uchar *s = p1.buf();
+		uchar	    *d = p2.buf();
+		auto stripe = [&](int k) {
+			IP_medianStripe(s, w, h, k*sw, MIN(w, (k+1)*sw), sz, avg, d);
+		};
+		IP_parallelFor((w + sw - 1) / sw, stripe, threads);
+	}
+}
+
+//@}
@@ -31,7 +31,7 @@ using namespace IP;
 //
 template<class T>
 inline bool
-IP_getChannel(ImagePtr I, int ch, ChannelPtr<T> &ptr, int &type)
+IP_getChannel(const ImagePtr &I, int ch, ChannelPtr<T> &ptr, int &type)
 {
 	if(ch<0 || ch>MXCHANNEL) {
 		fprintf(stderr, "IP_getChannel: Illegal channel %d\n", ch);
@@ -41,7 +41,8 @@ IP_getChannel(ImagePtr I, int ch, ChannelPtr<T> &ptr, int &type)
 		return false;
 	}
 
-	ptr  = I[ch];
+	// a channel of unset type has no buffer (as ImagePtr::operator[])
+	ptr  = (I->channelType(ch) < 0) ? (Channel *) 0 : (*I)[ch];
 	type = I->channelType(ch);
 	return true;
 }
@@ -81,7 +82,7 @@ IP_copyFromRow(ChannelPtr<T1> p, int row, int w, ChannelPtr<T2> q)
 //
 template<class T>
 inline void
-IP_copyFromRow(ImagePtr I, int ch, int row, ChannelPtr<T> p)
+IP_copyFromRow(const ImagePtr &I, int ch, int row, ChannelPtr<T> p)
 {
 	int w = I->width();
 	int type = I->channelType(ch);
@@ -165,7 +166,7 @@ IP_copyToRow(ChannelPtr<T1> p, ChannelPtr<T2> q, int row, int w)
 //
 template<class T>
 inline void
-IP_copyToRow(ChannelPtr<T> p, ImagePtr I, int ch, int row)
+IP_copyToRow(ChannelPtr<T> p, const ImagePtr &I, int ch, int row)
 {
 	int w = I->width();
 	int type = I->channelType(ch);
@@ -0,0 +1,273 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPparallel.h - Thread helpers for multithreaded IP functions.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPparallel.h
+//! \brief	Thread helpers for multithreaded IP functions.
+//! \author	George Wolberg, 2015
+
+#ifndef IPPARALLEL_H
+#define IPPARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace IP {
+
+//! \addtogroup parallel
+//@{
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_threadCount:
+//
+// Return number of threads to use for a request of n threads:
+// n if n > 0, otherwise the number of hardware threads.
+//! \brief	Number of threads to use for a request of \a n threads.
+//! \param[in]	n - Requested thread count; 0 selects all cores.
+//! \return	Thread count (at least 1).
+//
+inline int
+IP_threadCount(int n = 0)
+{
+	if(n > 0) return n;
+	n = (int) std::thread::hardware_concurrency();
+	return (n > 0) ? n : 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ThreadPool:
+//
+//! \brief	Persistent worker threads behind IP_parallelFor().
+//! \details	Workers are started on demand, up to the largest number
+//!		requested so far, and then wait for tasks instead of
+//!		exiting, so a parallel loop costs a wakeup per helper
+//!		rather than a thread creation. Tasks are run in the order
+//!		they are queued. The pool is never destroyed; its threads
+//!		end with the process. All methods are thread-safe.
+//
+class ThreadPool {
+public:
+	static ThreadPool &instance();
+
+	void	run	(const std::function<void()> &, int);
+	int	threads	() const;
+
+private:
+	ThreadPool();
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+
+	void	work	();
+
+	mutable std::mutex			m_mutex;
+	std::condition_variable			m_cond;
+	std::deque<std::function<void()> >	m_tasks;	// queued tasks
+	int					m_threads;	// # of workers
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ThreadPool::ThreadPool:
+//
+// Constructor. Workers are started by run().
+//
+inline
+ThreadPool::ThreadPool()
+	: m_threads(0)
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ThreadPool::instance:
+//
+// Return the process-wide pool. It is never destroyed, so that no
+// worker is joined or killed during program exit.
+//! \brief	Process-wide thread pool.
+//
+inline ThreadPool &
+ThreadPool::instance()
+{
+	static ThreadPool *pool = new ThreadPool;
+	return *pool;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ThreadPool::run:
+//
+// Queue count copies of task, starting workers until there are at
+// least count of them. Return without waiting for the tasks.
+//! \brief	Run \a count copies of \a task on worker threads.
+//! \param[in]	task  - Function object called as task().
+//! \param[in]	count - Number of copies.
+//
+inline void
+ThreadPool::run(const std::function<void()> &task, int count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for(int i=0; i<count; ++i)
+		m_tasks.push_back(task);
+	for(; m_threads < count; ++m_threads)
+		std::thread(&ThreadPool::work, this).detach();
+	m_cond.notify_all();
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ThreadPool::threads:
+//
+// Return the number of worker threads started so far.
+//
+inline int
+ThreadPool::threads() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_threads;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ThreadPool::work:
+//
+// Body of a worker: run queued tasks, waiting while there are none.
+//
+inline void
+ThreadPool::work()
+{
+	for(;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while(m_tasks.empty()) m_cond.wait(lock);
+			task.swap(m_tasks.front());
+			m_tasks.pop_front();
+		}
+		task();
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ParallelJob:
+//
+//! \brief	Shared state of one IP_parallelFor() loop.
+//! \details	The calling thread and the pool workers that join the loop
+//!		claim indices from m_next in increasing order. A worker
+//!		that starts after the last index is claimed leaves without
+//!		touching m_f, so the job outlives the call only through the
+//!		shared pointers of such late workers.
+//
+class ParallelJob {
+public:
+	ParallelJob(int n, const std::function<void(int)> &f)
+		: m_n(n), m_next(0), m_left(n), m_f(f) {}
+
+	void	work();
+	void	wait();
+
+private:
+	int			 m_n;		// # of indices
+	std::atomic<int>	 m_next;	// next index to hand out
+	std::atomic<int>	 m_left;	// # of indices not finished
+	std::function<void(int)> m_f;		// loop body
+	std::mutex		 m_mutex;
+	std::condition_variable	 m_done;	// signaled when m_left is 0
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ParallelJob::work:
+//
+// Claim indices and call the loop body on them until none are left.
+//
+inline void
+ParallelJob::work()
+{
+	for(int i; (i = m_next.fetch_add(1)) < m_n; ) {
+		m_f(i);
+		if(m_left.fetch_sub(1) == 1) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_done.notify_all();
+		}
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ParallelJob::wait:
+//
+// Wait until the loop body has returned for every index.
+//
+inline void
+ParallelJob::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(m_left.load()) m_done.wait(lock);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_parallelFor:
+//
+// Call f(i) for i = 0..n-1 on up to threads threads: the calling
+// thread and threads-1 workers of ThreadPool.
+// Indices are handed out in increasing order, and an index is handed
+// out only to a thread that runs it at once, so when f(i) starts, every
+// f(j) with j < i has started too; f(i) may therefore wait on progress
+// made by f(i-1) without deadlocking, even if the pool is busy or f
+// calls IP_parallelFor() itself.
+//! \brief	Call \a f(i) for \a i = 0..n-1 on several threads.
+//! \details	Indices are handed out in increasing order. With one
+//!		thread (or n = 1) f is called in order on the calling thread.
+//! \param[in]	n	- Number of work items.
+//! \param[in]	f	- Function object called as f(int).
+//! \param[in]	threads	- Thread count; 0 selects all cores.
+//
+template<class F>
+void
+IP_parallelFor(int n, F f, int threads = 0)
+{
+	threads = IP_threadCount(threads);
+	if(threads > n) threads = n;
+	if(threads <= 1) {
+		for(int i=0; i<n; ++i) f(i);
+		return;
+	}
+
+	std::shared_ptr<ParallelJob> job(new ParallelJob(n, [&f](int i) {
+		f(i);
+	}));
+	ThreadPool::instance().run([job]() { job->work(); }, threads-1);
+
+	// calling thread does its share of the work
+	job->work();
+	job->wait();
+}
+
+//@}
+
+}	// namespace IP
+
+#endif	// IPPARALLEL_H
@@ -0,0 +1,345 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPpoint.tpp - Point operations on uchar images through lookup tables.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPpoint.tpp
+//! \brief	Point operations on uchar images through lookup tables.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_contrast	    (ImagePtr, double, double, double, ImagePtr);
+extern void IP_gammaCorrect (ImagePtr, double, ImagePtr);
+extern void IP_clip	    (ImagePtr, double, double, ImagePtr);
+extern void IP_scaleRange   (ImagePtr, double, double, ImagePtr);
+extern int  IP_addConst	    (ImagePtr, double *, ImagePtr);
+extern int  IP_multiplyConst(ImagePtr, double *, ImagePtr);
+
+//! \addtogroup filtpt
+//@{
+
+// ----------------------------------------------------------------------
+// The IP_*Fast() functions below take the same arguments as the library
+// point operations they are named after. On images whose channels are
+// all uchar, the operation is a function of the input value alone, so
+// it is tabulated once into a MXGRAY-entry table and applied with
+// IP_lookup(), whose AVX2 kernel is chosen at runtime. Other channel
+// types are passed on to the library function. The tables reproduce the
+// library bit for bit, truncation included (see TestPoint.cpp).
+//
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_isUcharImage:
+//
+// Return true if I is not empty and all of its channels are uchar.
+//
+inline bool
+IP_isUcharImage(const ImagePtr &I)
+{
+	if(I.isNull()) return false;
+	for(int ch=0; ch<I->maxChannel(); ch++)
+		if(I->channelType(ch) != UCHAR_TYPE) return false;
+	return true;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_gammaLut:
+//
+// lut <- Gamma correction curve of IP_gammaCorrect(): gamma <= 0 is taken
+// as 0.1, gamma = 1 leaves values unchanged, and otherwise v maps to
+// MaxGray*(v/MaxGray)^(1/gamma), truncated (see IP_diffuseLut()).
+//! \brief	Build gamma correction lookup table.
+//! \param[in]	gamma - Gamma correction.
+//! \param[out]	lut   - Lookup table of MXGRAY entries.
+//
+inline void
+IP_gammaLut(double gamma, uchar *lut)
+{
+	if(gamma <= 0) gamma = .1;
+	for(int i=0; i<MXGRAY; i++) {
+		double v = MaxGray * pow((double) i/MaxGray, 1./gamma);
+		lut[i]	 = (gamma == 1) ? i : (uchar) (int) v;
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_scaleLut:
+//
+// lut <- Linear map of [lo, hi] onto [t1, t2] of IP_scaleRange(): v maps
+// to (v-lo)*((t2-t1)/(hi-lo)) + t1, truncated. Requires lo < hi and
+// 0 <= t1, t2 <= MaxGray; entries outside [lo, hi] are not used.
+//! \brief	Build linear range mapping lookup table.
+//! \param[in]	lo,hi - Input range.
+//! \param[in]	t1,t2 - Output range.
+//! \param[out]	lut   - Lookup table of MXGRAY entries.
+//
+inline void
+IP_scaleLut(int lo, int hi, double t1, double t2, uchar *lut)
+{
+	double scale = (t2 - t1) / (hi - lo);
+	memset(lut, 0, MXGRAY);
+	for(int i=lo; i<=hi; i++)
+		lut[i] = (uchar) (int) ((i - lo) * scale + t1);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_affineLut:
+//
+// lut <- v*scale + offset, clipped to [0, MaxGray] and truncated.
+// Covers IP_addConst() (scale 1) and IP_multiplyConst() (offset 0, or
+// MaxGray for a negative scale).
+//! \brief	Build affine lookup table.
+//! \param[in]	scale  - Multiplier.
+//! \param[in]	offset - Additive constant.
+//! \param[out]	lut    - Lookup table of MXGRAY entries.
+//
+inline void
+IP_affineLut(double scale, double offset, uchar *lut)
+{
+	for(int i=0; i<MXGRAY; i++) {
+		double v = i*scale + offset;
+		lut[i] = (v > MaxGray) ? MaxGray : (v < 0) ? 0 : (uchar) (int) v;
+	}
+}
+
+
+
+#if defined(IP_AVX2)
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_rangeRowAVX2:
+//
+// AVX2 part of IP_rangeRow(): fold the first n/32*32 bytes into lo, hi.
+// Return the number of bytes done.
+//
+IP_TARGET_AVX2 inline int
+IP_rangeRowAVX2(const uchar *src, int n, int &lo, int &hi)
+{
+	if(n < 32) return 0;
+
+	__m256i mn = _mm256_set1_epi8((char) lo);
+	__m256i mx = _mm256_set1_epi8((char) hi);
+	int i = 0;
+	for(; i+32<=n; i+=32) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (src + i));
+		mn = _mm256_min_epu8(mn, x);
+		mx = _mm256_max_epu8(mx, x);
+	}
+
+	uchar a[32], b[32];
+	_mm256_storeu_si256((__m256i *) a, mn);
+	_mm256_storeu_si256((__m256i *) b, mx);
+	for(int k=0; k<32; k++) {
+		lo = MIN(lo, a[k]);
+		hi = MAX(hi, b[k]);
+	}
+	return i;
+}
+#endif
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_rangeRow:
+//
+// Fold the minimum and maximum of n bytes into lo and hi. Start with
+// lo = MaxGray and hi = 0 for the range of src alone.
+//! \brief	Range of a row of bytes.
+//! \param[in]	 src   - Input bytes.
+//! \param[in]	 n     - Number of bytes.
+//! \param[in,out] lo,hi - Running minimum and maximum.
+//
+inline void
+IP_rangeRow(const uchar *src, int n, int &lo, int &hi)
+{
+	int i = 0;
+#if defined(IP_AVX2)
+	if(IP_hasAVX2()) i = IP_rangeRowAVX2(src, n, lo, hi);
+#endif
+	for(; i<n; i++) {
+		lo = MIN(lo, src[i]);
+		hi = MAX(hi, src[i]);
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_contrastFast:
+//
+// IP_contrast() through a lookup table (see IP_toneLut()).
+//! \brief	Brightness/contrast adjustment.
+//! \param[in]	I1	   - Input image.
+//! \param[in]	brightness - Brightness offset.
+//! \param[in]	contrast   - Contrast factor.
+//! \param[in]	ref	   - Reference gray level.
+//! \param[out]	I2	   - Output image.
+//
+inline void
+IP_contrastFast(const ImagePtr &I1, double brightness, double contrast,
+		double ref, const ImagePtr &I2)
+{
+	if(!IP_isUcharImage(I1)) {
+		IP_contrast(I1, brightness, contrast, ref, I2);
+		return;
+	}
+	uchar lut[MXGRAY];
+	IP_toneLut(brightness, contrast, ref, lut);
+	IP_lookup(I1, lut, I2);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_gammaCorrectFast:
+//
+// IP_gammaCorrect() through a lookup table (see IP_gammaLut()).
+//! \brief	Gamma correction.
+//! \param[in]	I1    - Input image.
+//! \param[in]	gamma - Gamma correction.
+//! \param[out]	I2    - Output image.
+//
+inline void
+IP_gammaCorrectFast(const ImagePtr &I1, double gamma, const ImagePtr &I2)
+{
+	if(!IP_isUcharImage(I1)) {
+		IP_gammaCorrect(I1, gamma, I2);
+		return;
+	}
+	uchar lut[MXGRAY];
+	IP_gammaLut(gamma, lut);
+	IP_lookup(I1, lut, I2);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_clipFast:
+//
+// IP_clip() through a lookup table: values below t1 become t1 and
+// values above t2 become t2, both truncated.
+//! \brief	Clip values to [\a t1, \a t2].
+//! \param[in]	I1    - Input image.
+//! \param[in]	t1,t2 - Clip range.
+//! \param[out]	I2    - Output image.
+//
+inline void
+IP_clipFast(const ImagePtr &I1, double t1, double t2, const ImagePtr &I2)
+{
+	if(!IP_isUcharImage(I1)) {
+		IP_clip(I1, t1, t2, I2);
+		return;
+	}
+	uchar lut[MXGRAY];
+	for(int i=0; i<MXGRAY; i++) {
+		if(t1 > i)	lut[i] = (uchar) (int) t1;
+		else if(i > t2) lut[i] = (uchar) (int) t2;
+		else		lut[i] = i;
+	}
+	IP_lookup(I1, lut, I2);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_scaleRangeFast:
+//
+// IP_scaleRange() through lookup tables: the range of each channel of
+// I1 is mapped linearly onto [t1, t2]. Costs one pass to find the ranges
+// and one to apply the tables. A constant channel or a range outside
+// [0, MaxGray] is passed on to the library, which reports it.
+//! \brief	Scale the range of an image to [\a t1, \a t2].
+//! \param[in]	I1    - Input image.
+//! \param[in]	t1,t2 - Output range.
+//! \param[out]	I2    - Output image.
+//
+inline void
+IP_scaleRangeFast(const ImagePtr &I1, double t1, double t2,
+		  const ImagePtr &I2)
+{
+	if(!IP_isUcharImage(I1)) {
+		IP_scaleRange(I1, t1, t2, I2);
+		return;
+	}
+	int nch = I1->maxChannel();
+	int n	= I1->width() * I1->height();
+	std::vector<uchar> lut((size_t) nch * MXGRAY);
+	for(int ch=0; ch<nch; ch++) {
+		int lo = MaxGray;
+		int hi = 0;
+		ChannelPtr<uchar> p1 = (*I1)[ch];
+		IP_rangeRow(p1.buf(), n, lo, hi);
+		if(lo == hi || t1 < 0 || t2 > MaxGray) {
+			IP_scaleRange(I1, t1, t2, I2);
+			return;
+		}
+		IP_scaleLut(lo, hi, t1, t2, &lut[(size_t) ch * MXGRAY]);
+	}
+	IP_lookup(I1, lut.data(), I2, MXGRAY);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_addConstFast:
+//
+// IP_addConst() through lookup tables: c[ch] is added to channel ch,
+// and sums are clipped to [0, MaxGray].
+// Return 1 for success, 0 for failure.
+//! \brief	Add a constant per channel.
+//! \param[in]	I1 - Input image.
+//! \param[in]	c  - Constant for each channel.
+//! \param[out]	I2 - Output image.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_addConstFast(const ImagePtr &I1, double *c, const ImagePtr &I2)
+{
+	if(!IP_isUcharImage(I1))
+		return IP_addConst(I1, c, I2);
+
+	std::vector<uchar> lut((size_t) I1->maxChannel() * MXGRAY);
+	for(int ch=0; ch<I1->maxChannel(); ch++)
+		IP_affineLut(1., c[ch], &lut[(size_t) ch * MXGRAY]);
+	return IP_lookup(I1, lut.data(), I2, MXGRAY);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_multiplyConstFast:
+//
+// IP_multiplyConst() through lookup tables: channel ch is multiplied by
+// c[ch], and products are clipped to [0, MaxGray]. As in the library, a
+// negative c[ch] maps v to v*c[ch] + MaxGray.
+// Return 1 for success, 0 for failure.
+//! \brief	Multiply by a constant per channel.
+//! \param[in]	I1 - Input image.
+//! \param[in]	c  - Constant for each channel.
+//! \param[out]	I2 - Output image.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_multiplyConstFast(const ImagePtr &I1, double *c, const ImagePtr &I2)
+{
+	if(!IP_isUcharImage(I1))
+		return IP_multiplyConst(I1, c, I2);
+
+	std::vector<uchar> lut((size_t) I1->maxChannel() * MXGRAY);
+	for(int ch=0; ch<I1->maxChannel(); ch++)
+		IP_affineLut(c[ch], (c[ch] < 0) ? MaxGray : 0.,
+			     &lut[(size_t) ch * MXGRAY]);
+	return IP_lookup(I1, lut.data(), I2, MXGRAY);
+}
+
+//@}
@@ -0,0 +1,235 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPscratch.h - Per-thread scratch memory for scanline kernels.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPscratch.h
+//! \brief	Per-thread scratch memory for scanline kernels.
+//! \author	George Wolberg, 2015
+
+#ifndef IPSCRATCH_H
+#define IPSCRATCH_H
+
+#include <cstddef>
+#include <vector>
+#include <QThreadStorage>
+
+namespace IP {
+
+//! \addtogroup parallel
+//@{
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena class declaration
+//! \brief	Per-thread bump allocator for temporary buffers.
+//! \details	Memory is handed out from a list of blocks that is kept
+//!		for the lifetime of the thread, so steady-state use does
+//!		not touch the heap. Allocations are released in LIFO order
+//!		by rolling back to a mark; use ScratchScope for that.
+//!		Each thread gets its own arena from local().
+//
+class ScratchArena {
+public:
+	//! Position in the arena, as returned by mark().
+	struct Mark {
+		int	block;		// current block
+		size_t	used;		// bytes used in current block
+	};
+
+	ScratchArena();
+	~ScratchArena();
+
+	static ScratchArena &local();
+
+	void	*alloc	(size_t);
+	Mark	 mark	() const;
+	void	 release(const Mark &);
+
+	//! \brief	Allocate \a n objects of type \a T (uninitialized).
+	template<class T>
+	T	*alloc	(size_t n) { return static_cast<T *>(alloc(n * sizeof(T))); }
+
+private:
+	enum { ALIGN = 64, MINBLOCK = 64 * 1024 };
+
+	struct Block {
+		char	*mem;		// allocated memory
+		char	*base;		// mem rounded up to ALIGN
+		size_t	 size;		// usable bytes at base
+	};
+
+	// not copyable
+	ScratchArena(const ScratchArena &);
+	ScratchArena &operator=(const ScratchArena &);
+
+	void	 setBlock(Block &, size_t);
+
+	std::vector<Block> m_blocks;	// blocks in allocation order
+	int		   m_cur;	// current block (-1: none)
+	size_t		   m_used;	// bytes used in current block
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchScope class declaration
+//! \brief	Scoped allocation from the calling thread's arena.
+//! \details	Everything allocated through a ScratchScope is released
+//!		when it goes out of scope.
+//
+class ScratchScope {
+public:
+	ScratchScope() : m_arena(ScratchArena::local()), m_mark(m_arena.mark()) {}
+	~ScratchScope() { m_arena.release(m_mark); }
+
+	//! \brief	Allocate \a n objects of type \a T (uninitialized).
+	template<class T>
+	T	*alloc(size_t n) { return m_arena.alloc<T>(n); }
+
+private:
+	// not copyable
+	ScratchScope(const ScratchScope &);
+	ScratchScope &operator=(const ScratchScope &);
+
+	ScratchArena	  &m_arena;	// arena of the calling thread
+	ScratchArena::Mark m_mark;	// arena position at construction
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena::ScratchArena:
+//
+// Constructor. Blocks are allocated on first use.
+//
+inline
+ScratchArena::ScratchArena()
+	: m_cur (-1),
+	  m_used(0)
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena::~ScratchArena:
+//
+// Destructor. Free all blocks.
+//
+inline
+ScratchArena::~ScratchArena()
+{
+	for(size_t i=0; i<m_blocks.size(); ++i)
+		delete [] m_blocks[i].mem;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena::local:
+//
+// Return the arena of the calling thread. It is created on first use
+// and freed when the thread exits.
+//! \brief	Arena of the calling thread.
+//
+inline ScratchArena &
+ScratchArena::local()
+{
+	static QThreadStorage<ScratchArena *> arenas;
+	if(!arenas.hasLocalData())
+		arenas.setLocalData(new ScratchArena);
+	return *arenas.localData();
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena::alloc:
+//
+// Return size bytes aligned to ALIGN bytes. Move on to the next block
+// when the current one is full, replacing that block if it is too small.
+//! \brief	Allocate \a size bytes (64-byte aligned).
+//! \param[in]	size - Number of bytes.
+//! \return	Pointer to uninitialized memory.
+//
+inline void *
+ScratchArena::alloc(size_t size)
+{
+	size_t start = (m_used + ALIGN-1) & ~(size_t) (ALIGN-1);
+	if(m_cur < 0 || start + size > m_blocks[m_cur].size) {
+		// advance to next block
+		++m_cur;
+		start = 0;
+		if(m_cur == (int) m_blocks.size()) {
+			Block b = {0, 0, 0};
+			m_blocks.push_back(b);
+		}
+
+		// blocks at least double in size
+		Block &b = m_blocks[m_cur];
+		if(b.size < size) {
+			size_t n = MINBLOCK;
+			if(m_cur) n = 2 * m_blocks[m_cur-1].size;
+			while(n < size) n *= 2;
+			setBlock(b, n);
+		}
+	}
+	m_used = start + size;
+	return m_blocks[m_cur].base + start;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena::mark:
+//
+// Return current arena position.
+//! \brief	Current arena position.
+//
+inline ScratchArena::Mark
+ScratchArena::mark() const
+{
+	Mark m = {m_cur, m_used};
+	return m;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena::release:
+//
+// Release everything allocated after mark m was taken.
+// Blocks are kept for reuse.
+//! \brief	Roll arena back to mark \a m.
+//
+inline void
+ScratchArena::release(const Mark &m)
+{
+	m_cur  = m.block;
+	m_used = m.used;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ScratchArena::setBlock:
+//
+// (Re)allocate block b to hold size bytes. The block must be unused.
+//
+inline void
+ScratchArena::setBlock(Block &b, size_t size)
+{
+	delete [] b.mem;
+	b.mem  = new char[size + ALIGN-1];
+	b.base = b.mem + ((ALIGN - (size_t) b.mem % ALIGN) % ALIGN);
+	b.size = size;
+}
+
+//@}
+
+}	// namespace IP
+
+#endif	// IPSCRATCH_H
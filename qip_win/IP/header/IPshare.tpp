@@ -0,0 +1,40 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPshare.tpp - Input images of in-place filters.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPshare.tpp
+//! \brief	Input images of in-place filters.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+//! \addtogroup mmimg
+//@{
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_inPlaceSource:
+//
+// Return the image that a filter writing into I2 should read I1 from:
+// I1 itself, or a copy of it if I1 and I2 are the same image, so that
+// pixels still to be read are not overwritten.
+//! \brief	Input image of a filter that may run in place.
+//! \param[in]	I1 - Input image.
+//! \param[in]	I2 - Output image.
+//! \return	I1, or a copy of I1 if I1 == I2.
+//
+inline ImagePtr
+IP_inPlaceSource(const ImagePtr &I1, const ImagePtr &I2)
+{
+	if(I1 != I2) return I1;
+
+	ImagePtr I;
+	IP_copyImage(I1, I);
+	return I;
+}
+
+//@}
@@ -0,0 +1,202 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPsimd.h - Runtime selection of SIMD instruction sets.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPsimd.h
+//! \brief	Runtime selection of SIMD instruction sets.
+//! \author	George Wolberg, 2015
+
+#ifndef IPSIMD_H
+#define IPSIMD_H
+
+// ----------------------------------------------------------------------
+// IP_SSE2, IP_AVX2 and IP_AVX512 are defined when kernels for that
+// instruction set can be compiled on this target. The kernels are marked
+// IP_TARGET_SSE2, IP_TARGET_AVX2 or IP_TARGET_AVX512 so that they build
+// without -mavx2 or /arch:AVX2, and callers run them only if
+// IP_hasSSE2(), IP_hasAVX2() or IP_hasAVX512() is true; every kernel
+// keeps a scalar path for other CPUs. AVX-512 means AVX-512F here.
+// IP_POPCNT and IP_TARGET_POPCNT do the same for the POPCNT instruction
+// (IP_hasPOPCNT()). Define IP_NO_SIMD to force the scalar paths.
+//
+#if !defined(IP_NO_SIMD)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IP_SSE2
+#define IP_AVX2
+#define IP_AVX512
+#define IP_TARGET_SSE2	__attribute__((target("sse2")))
+#define IP_TARGET_AVX2	__attribute__((target("avx2")))
+#define IP_TARGET_AVX512 __attribute__((target("avx512f")))
+#define IP_POPCNT
+#define IP_TARGET_POPCNT __attribute__((target("popcnt")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define IP_SSE2
+#define IP_AVX2
+#define IP_TARGET_SSE2
+#define IP_TARGET_AVX2
+#if defined(_M_X64)		// __popcnt64: x64 only
+#define IP_POPCNT
+#define IP_TARGET_POPCNT
+#endif
+#if _MSC_VER >= 1911		// AVX-512 intrinsics: VS 2017 15.3 and up
+#define IP_AVX512
+#define IP_TARGET_AVX512
+#endif
+#endif
+#endif
+
+#if defined(IP_SSE2)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace IP {
+
+//! \addtogroup parallel
+//@{
+
+#if defined(IP_SSE2) && defined(_MSC_VER)
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_cpuFeatures:
+//
+// Query the CPU with cpuid and xgetbv (MSVC). Return the IP_CPU_* bits
+// of the instruction sets that the CPU and the operating system support.
+//
+enum {
+	IP_CPU_SSE2   = 1,
+	IP_CPU_AVX2   = 2,
+	IP_CPU_AVX512 = 4,
+	IP_CPU_POPCNT = 8
+};
+
+inline int
+IP_cpuFeatures()
+{
+	int r[4], f = 0;
+	__cpuid(r, 0);
+	int maxLeaf = r[0];
+	__cpuid(r, 1);
+	if(r[3] & 0x04000000) f |= IP_CPU_SSE2;
+	if(r[2] & 0x00800000) f |= IP_CPU_POPCNT;
+
+	// OSXSAVE and AVX, and the OS saves the ymm registers
+	if(maxLeaf < 7 || (r[2] & 0x18000000) != 0x18000000) return f;
+	unsigned xcr0 = (unsigned) _xgetbv(0);
+	if((xcr0 & 6) != 6) return f;
+	__cpuidex(r, 7, 0);
+	if(r[1] & 0x20) f |= IP_CPU_AVX2;
+
+	// AVX-512F, and the OS also saves the opmask and zmm registers
+	if((r[1] & 0x10000) && (xcr0 & 0xE6) == 0xE6) f |= IP_CPU_AVX512;
+	return f;
+}
+#endif
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_hasSSE2:
+//
+// Return true if the CPU supports SSE2. The CPU is queried once; later
+// calls return the saved answer.
+//! \brief	Test if SSE2 kernels may run.
+//! \return	A boolean value.
+//
+inline bool
+IP_hasSSE2()
+{
+#if defined(IP_SSE2) && defined(__GNUC__)
+	static const bool sse2 = __builtin_cpu_supports("sse2");
+	return sse2;
+#elif defined(IP_SSE2)
+	static const bool sse2 = (IP_cpuFeatures() & IP_CPU_SSE2) != 0;
+	return sse2;
+#else
+	return false;
+#endif
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_hasAVX2:
+//
+// Return true if the CPU and the operating system support AVX2. The
+// CPU is queried once; later calls return the saved answer.
+//! \brief	Test if AVX2 kernels may run.
+//! \return	A boolean value.
+//
+inline bool
+IP_hasAVX2()
+{
+#if defined(IP_AVX2) && defined(__GNUC__)
+	static const bool avx2 = __builtin_cpu_supports("avx2");
+	return avx2;
+#elif defined(IP_AVX2)
+	static const bool avx2 = (IP_cpuFeatures() & IP_CPU_AVX2) != 0;
+	return avx2;
+#else
+	return false;
+#endif
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_hasAVX512:
+//
+// Return true if the CPU and the operating system support AVX-512F.
+// The CPU is queried once; later calls return the saved answer.
+//! \brief	Test if AVX-512 kernels may run.
+//! \return	A boolean value.
+//
+inline bool
+IP_hasAVX512()
+{
+#if defined(IP_AVX512) && defined(__GNUC__)
+	static const bool avx512 = __builtin_cpu_supports("avx512f");
+	return avx512;
+#elif defined(IP_AVX512)
+	static const bool avx512 = (IP_cpuFeatures() & IP_CPU_AVX512) != 0;
+	return avx512;
+#else
+	return false;
+#endif
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_hasPOPCNT:
+//
+// Return true if the CPU supports the POPCNT instruction. The CPU is
+// queried once; later calls return the saved answer.
+//! \brief	Test if POPCNT kernels may run.
+//! \return	A boolean value.
+//
+inline bool
+IP_hasPOPCNT()
+{
+#if defined(IP_POPCNT) && defined(__GNUC__)
+	static const bool popcnt = __builtin_cpu_supports("popcnt");
+	return popcnt;
+#elif defined(IP_POPCNT)
+	static const bool popcnt = (IP_cpuFeatures() & IP_CPU_POPCNT) != 0;
+	return popcnt;
+#else
+	return false;
+#endif
+}
+
+//@}
+
+}	// namespace IP
+
+#endif	// IPSIMD_H
@@ -0,0 +1,166 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPtone.tpp - Tone curve lookup tables.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPtone.tpp
+//! \brief	Tone curve lookup tables.
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+extern void IP_allocImageInI(ImagePtr, int, int, int*);
+
+//! \addtogroup filtpt
+//@{
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_toneLut:
+//
+// lut <- Brightness/contrast curve of IP_contrast(): input v maps to
+// (v-ref)*contrast + (brightness+ref), truncated and clipped to
+// [0,MaxGray] as the library does. The table has MXGRAY entries.
+//! \brief	Build brightness/contrast lookup table.
+//! \param[in]	brightness - Brightness offset.
+//! \param[in]	contrast   - Contrast factor.
+//! \param[in]	ref	   - Reference gray level (unchanged by contrast).
+//! \param[out]	lut	   - Lookup table of MXGRAY entries.
+//
+inline void
+IP_toneLut(double brightness, double contrast, double ref, uchar *lut)
+{
+	double offset = brightness + ref;
+	for(int i=0; i<MXGRAY; i++) {
+		double v = (i - ref) * contrast + offset;
+		lut[i] = (v < 1) ? 0 : (v >= MaxGray) ? MaxGray : (uchar) (int) v;
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_composeLut:
+//
+// lut <- lut2 applied after lut1, so that one lookup does the work of
+// two. lut may be lut1 or lut2.
+//! \brief	Compose two lookup tables.
+//! \param[in]	lut1 - First lookup table.
+//! \param[in]	lut2 - Second lookup table.
+//! \param[out]	lut  - lut2[lut1[v]].
+//
+inline void
+IP_composeLut(const uchar *lut1, const uchar *lut2, uchar *lut)
+{
+	uchar tmp[MXGRAY];
+	for(int i=0; i<MXGRAY; i++) tmp[i] = lut2[lut1[i]];
+	memcpy(lut, tmp, MXGRAY);
+}
+
+
+
+#if defined(IP_AVX2)
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_lookupRowAVX2:
+//
+// AVX2 part of IP_lookupRow(): look up the first n/32*32 bytes, 32 at a
+// time, with a byte shuffle per 16-entry slice of the table. At step k
+// the index is src-16k, and adding 0x70 with unsigned saturation sets
+// the high bit, which makes the shuffle return 0, unless src is in
+// slice k. ORing the 16 shuffles leaves one table entry per pixel.
+// Return the number of bytes done.
+//
+IP_TARGET_AVX2 inline int
+IP_lookupRowAVX2(const uchar *src, int n, const uchar *lut, uchar *dst)
+{
+	__m256i t[16];
+	for(int k=0; k<16; k++)
+		t[k] = _mm256_broadcastsi128_si256(
+			_mm_loadu_si128((const __m128i *) (lut + 16*k)));
+	const __m256i bias = _mm256_set1_epi8(0x70);
+	const __m256i step = _mm256_set1_epi8(16);
+
+	int i = 0;
+	for(; i+32<=n; i+=32) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (src + i));
+		__m256i r = _mm256_setzero_si256();
+		for(int k=0; k<16; k++) {
+			__m256i idx = _mm256_adds_epu8(x, bias);
+			r = _mm256_or_si256(r, _mm256_shuffle_epi8(t[k], idx));
+			x = _mm256_sub_epi8(x, step);
+		}
+		_mm256_storeu_si256((__m256i *) (dst + i), r);
+	}
+	return i;
+}
+#endif
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_lookupRow:
+//
+// dst <- lut[src] for n bytes. src and dst may be the same buffer.
+// Runs 32 pixels at a time on CPUs with AVX2 (see IP_hasAVX2()). The
+// same shuffle scheme on 16-byte SSSE3 registers is slower than scalar
+// lookups, so other CPUs take the scalar loop.
+//! \brief	Apply lookup table to a row of bytes.
+//! \param[in]	src - Input bytes.
+//! \param[in]	n   - Number of bytes.
+//! \param[in]	lut - Lookup table of MXGRAY entries.
+//! \param[out]	dst - Output bytes.
+//
+inline void
+IP_lookupRow(const uchar *src, int n, const uchar *lut, uchar *dst)
+{
+	int i = 0;
+#if defined(IP_AVX2)
+	if(IP_hasAVX2()) i = IP_lookupRowAVX2(src, n, lut, dst);
+#endif
+	for(; i<n; i++) dst[i] = lut[src[i]];
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_lookup:
+//
+// I2 <- lut applied to every channel of I1, in one pass over memory.
+// If step is nonzero, channel ch uses the table at lut + ch*step.
+// The channels of I1 must be uchar. I1 and I2 may be the same image.
+// Return 1 for success, 0 for failure.
+//! \brief	Apply a lookup table to an image.
+//! \param[in]	I1   - Input image.
+//! \param[in]	lut  - Lookup table(s) of MXGRAY entries.
+//! \param[out]	I2   - Output image.
+//! \param[in]	step - Offset between tables of successive channels.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_lookup(const ImagePtr &I1, const uchar *lut, const ImagePtr &I2,
+	  int step = 0)
+{
+	if(I1.isNull()) return 0;
+	for(int ch=0; ch<I1->maxChannel(); ch++) {
+		if(I1->channelType(ch) != UCHAR_TYPE) {
+			fprintf(stderr, "IP_lookup: channel %d is not uchar\n", ch);
+			return 0;
+		}
+	}
+
+	if(I2 != I1)
+		IP_allocImageInI(I2, I1->width(), I1->height(),
+				 I1->channelTypes());
+	int n = I1->width() * I1->height();
+	for(int ch=0; ch<I1->maxChannel(); ch++) {
+		ChannelPtr<uchar> p1 = (*I1)[ch];
+		ChannelPtr<uchar> p2 = (*I2)[ch];
+		IP_lookupRow(p1.buf(), n, lut + ch*step, p2.buf());
+	}
+	return 1;
+}
+
+//@}
@@ -0,0 +1,208 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// IPview.tpp - Functions on image views (regions without a copy).
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	IPview.tpp
+//! \brief	Functions on image views (regions without a copy).
+//! \author	George Wolberg, 2015
+
+using namespace IP;
+
+//! \addtogroup mmimg
+//@{
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_viewRow:
+//
+// Return pointer to row y of channel ch of view V, as bytes.
+//
+inline uchar *
+IP_viewRow(const ImageView &V, int ch, int y)
+{
+	int   bpp = Image::channelBytes(1, V.channelType(ch));
+	uchar *p  = (uchar *) (*V.image())[ch]->buf();
+	return p + ((size_t) (V.yoffset()+y) * V.stride() + V.xoffset()) * bpp;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_copyFromView:
+//
+// I2 <- Pixels of view V, as a new image with the channel types of the
+// parent of V. This is IP_crop() for a view.
+//! \brief	Copy the pixels of a view into an image.
+//! \param[in]	V  - Input view.
+//! \param[out]	I2 - Output image.
+//
+inline void
+IP_copyFromView(const ImageView &V, const ImagePtr &I2)
+{
+	// output is the parent of V: fill a new image, then copy it back
+	if(I2 == V.image()) {
+		ImagePtr I;
+		IP_copyFromView(V, I);
+		IP_copyImage(I, I2);
+		return;
+	}
+
+	IP_allocImageInI(I2, V.width(), V.height(), V.image()->channelTypes());
+	for(int ch=0; ch<V.maxChannel(); ch++) {
+		int    n = Image::channelBytes(V.width(), V.channelType(ch));
+		uchar *p = (uchar *) (*I2)[ch]->buf();
+		for(int y=0; y<V.height(); y++, p+=n)
+			memcpy(p, IP_viewRow(V, ch, y), n);
+	}
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_copyToView:
+//
+// V <- Pixels of image I1, which must match V in size and channel types.
+// Return 1 for success, 0 for failure.
+//! \brief	Copy the pixels of an image into a view.
+//! \param[in]	I1 - Input image.
+//! \param[out]	V  - Output view.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_copyToView(const ImagePtr &I1, const ImageView &V)
+{
+	if(I1->width() != V.width() || I1->height() != V.height()) {
+		fprintf(stderr, "IP_copyToView: size mismatch\n");
+		return 0;
+	}
+	for(int ch=0; ch<V.maxChannel(); ch++) {
+		if(I1->channelType(ch) != V.channelType(ch)) {
+			fprintf(stderr, "IP_copyToView: channel type mismatch\n");
+			return 0;
+		}
+	}
+
+	for(int ch=0; ch<V.maxChannel(); ch++) {
+		int    n = Image::channelBytes(V.width(), V.channelType(ch));
+		uchar *p = (uchar *) (*I1)[ch]->buf();
+		for(int y=0; y<V.height(); y++, p+=n)
+			memmove(IP_viewRow(V, ch, y), p, n);
+	}
+	return 1;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_viewTiles:
+//
+// Split view V into tiles of at most tw x th pixels, in row-major order.
+// The tiles are views of the parent of V; they do not overlap, so they
+// may be processed in parallel with IP_parallelFor().
+// Return the number of tiles.
+//! \brief	Split a view into tiles.
+//! \param[in]	V     - Input view.
+//! \param[in]	tw,th - Maximum tile width and height.
+//! \param[out]	tiles - Tiles of \a V.
+//! \return	Number of tiles.
+//
+inline int
+IP_viewTiles(const ImageView &V, int tw, int th, std::vector<ImageView> &tiles)
+{
+	tiles.clear();
+	if(V.isNull() || tw <= 0 || th <= 0) return 0;
+
+	for(int y=0; y<V.height(); y+=th)
+	for(int x=0; x<V.width (); x+=tw)
+		tiles.push_back(ImageView(V, x, y, tw, th));
+	return (int) tiles.size();
+}
+
+//@}
+
+
+
+//! \addtogroup filtnbr
+//@{
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurView:
+//
+// Blur channel ch of view V1 into V2 with a xsz x ysz box filter, using
+// IP_blur1DScratch along rows (stride 1) and then along columns (stride
+// of V2); the output is that of IP_blur1D. The filter must fit the view;
+// the overload below checks it.
+//
+template<class T>
+void
+IP_blurView(const ImageView &V1, int ch, double xsz, double ysz,
+	    const ImageView &V2)
+{
+	int w = V2.width ();
+	int h = V2.height();
+	for(int y=0; y<h; y++)
+		IP_blur1DScratch(V1.row<T>(ch, y), w, 1, xsz, V2.row<T>(ch, y));
+
+	ChannelPtr<T> p = V2.channel<T>(ch);
+	for(int x=0; x<w; x++, p++)
+		IP_blur1DScratch(p, h, V2.stride(), ysz, p);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// IP_blurView:
+//
+// V2 <- Blur view V1 with a box filter of size xsz x ysz. Only the
+// pixels inside V1 are read and only the pixels inside V2 are written;
+// pixels outside the views are left untouched. V1 and V2 must have the
+// same size and channel types; they may be the same view but must not
+// otherwise overlap. The filter may not be larger than the views.
+// Channels of type uchar, short, int, float and double are blurred.
+// Return 1 for success, 0 for failure.
+//! \brief	Blur a region of an image in place or into another region.
+//! \param[in]	V1	 - Input view.
+//! \param[in]	xsz, ysz - Filter width and height.
+//! \param[out]	V2	 - Output view.
+//! \return	1 for success, 0 for failure.
+//
+inline int
+IP_blurView(const ImageView &V1, double xsz, double ysz, const ImageView &V2)
+{
+	if(V1.width() != V2.width() || V1.height() != V2.height()) {
+		fprintf(stderr, "IP_blurView: size mismatch\n");
+		return 0;
+	}
+	if(xsz > V1.width() || ysz > V1.height()) {
+		fprintf(stderr, "IP_blurView: filter exceeds view (%gx%g>%dx%d)\n",
+			xsz, ysz, V1.width(), V1.height());
+		return 0;
+	}
+	for(int ch=0; ch<V1.maxChannel(); ch++) {
+		if(V2.channelType(ch) != V1.channelType(ch)) {
+			fprintf(stderr, "IP_blurView: channel type mismatch\n");
+			return 0;
+		}
+	}
+
+	for(int ch=0; ch<V1.maxChannel(); ch++) {
+		int t = V1.channelType(ch);
+		switch(t) {
+		case  UCHAR_TYPE: IP_blurView<uchar >(V1, ch, xsz, ysz, V2); break;
+		case  SHORT_TYPE: IP_blurView<short >(V1, ch, xsz, ysz, V2); break;
+		case    INT_TYPE: IP_blurView<int   >(V1, ch, xsz, ysz, V2); break;
+		case  FLOAT_TYPE: IP_blurView<float >(V1, ch, xsz, ysz, V2); break;
+		case DOUBLE_TYPE: IP_blurView<double>(V1, ch, xsz, ysz, V2); break;
+		default:
+			fprintf(stderr, "IP_blurView: bad channel type %d\n", t);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//@}
@@ -44,6 +44,7 @@ public:
 	void	 allocImage  (int, int, const int*);
 	void	 allocImage_I(Image &);
 	Channel	*allocChannel(int size, int type);
+	static int channelBytes(int size, int type);
 
 	// reference counting
 	int	  link(bool=true);
@@ -320,20 +321,33 @@ Image::allocImage_I(Image &I)
 inline Channel *
 Image::allocChannel(int size, int type)
 {
-	int	total = size;
+	Channel *c = new Channel;
+	c->resize(channelBytes(size, type));
+	return c;
+}
+
 
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Image::channelBytes:
+//
+// Return number of bytes of a channel of size pixels of datatype type.
+//! \brief	Number of bytes of a channel buffer.
+//! \param[in]	size	- Buffer size (pixels).
+//! \param[in]	type	- Channel datatype.
+//
+inline int
+Image::channelBytes(int size, int type)
+{
 	switch(type) {
-	case  UCHAR_TYPE: total = size * sizeof(uchar ); break;
-	case  SHORT_TYPE: total = size * sizeof(short ); break;
-	case    INT_TYPE: total = size * sizeof(int   ); break;
-	case   LONG_TYPE: total = size * sizeof(long  ); break;
-	case  FLOAT_TYPE: total = size * sizeof(float ); break;
-	case DOUBLE_TYPE: total = size * sizeof(double); break;
+	case  UCHAR_TYPE: return size * sizeof(uchar );
+	case  SHORT_TYPE: return size * sizeof(short );
+	case    INT_TYPE: return size * sizeof(int   );
+	case   LONG_TYPE: return size * sizeof(long  );
+	case  FLOAT_TYPE: return size * sizeof(float );
+	case DOUBLE_TYPE: return size * sizeof(double);
 	};
-
-	Channel *c = new Channel;
-	c->resize(total);
-	return c;
+	return size;
 }
 
 
@@ -21,13 +21,17 @@ namespace IP {
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // ImagePtr class declaration
 //! \brief      ImagePtr class.
-//! \details	A smart pointer to the Image class.
+//! \details	A smart pointer to the Image class. Moving an ImagePtr
+//!		transfers the image without a link/unlink pair and leaves
+//!		the source null: isNull() is true, and it may only be
+//!		assigned to, tested or destroyed.
 //
 class ImagePtr {
 public:
 	// constructors
 	ImagePtr();			// default constructor
 	ImagePtr(const ImagePtr &p);	// copy constructor
+	ImagePtr(ImagePtr &&p);		// move constructor
 	ImagePtr(Image *p);		// construct from image ptr
 
 	// destructor
@@ -38,6 +42,7 @@ public:
 
 	// overloaded operators
 	ImagePtr &operator=(const ImagePtr &p);	// assignment
+	ImagePtr &operator=(ImagePtr &&p);	// move assignment
 	ImagePtr &operator=(Image *);		// assignment
 	Image	 *operator->() const;		// dereference
 	Image	 &operator* () const;		// value-at
@@ -109,6 +114,22 @@ ImagePtr::ImagePtr(const ImagePtr &p) : m_ptr(p.m_ptr)
 	if(m_ptr) m_ptr->link();
 }
 
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImagePtr::ImagePtr:
+//
+// Move constructor.
+//! \brief	Move constructor.
+//! \details	Take over the image of \a p without touching its reference
+//!		count. \a p is left null.
+//
+inline
+ImagePtr::ImagePtr(ImagePtr &&p) : m_ptr(p.m_ptr)
+{
+	p.m_ptr = NULL;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // ImagePtr::ImagePtr:
 //
@@ -208,6 +229,29 @@ ImagePtr::operator=(const ImagePtr &p)
 
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImagePtr::operator=:
+//
+// Move assignment operator.
+//! \brief	Move assignment operator.
+//! \details	Release the current image and take over the image of \a p
+//!		without touching its reference count. \a p is left null.
+//! \param[in]	p - An ImagePtr object.
+//! \return	A self-reference.
+//
+inline ImagePtr &
+ImagePtr::operator=(ImagePtr &&p)
+{
+	if(this != &p) {
+		_freePtr();
+		m_ptr	= p.m_ptr;
+		p.m_ptr = NULL;
+	}
+	return *this;
+}
+
+
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // ImagePtr::operator=:
 //
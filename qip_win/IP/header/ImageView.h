@@ -0,0 +1,368 @@
+// ======================================================================
+// IMPROC: Image Processing Software Package
+// Copyright (C) 2015 by George Wolberg
+//
+// ImageView.h - ImageView class.
+//
+// Written by: George Wolberg, 2015
+// ======================================================================
+
+//! \file	ImageView.h
+//! \brief	ImageView class.
+//! \author	George Wolberg, 2015
+
+#ifndef IMAGEVIEW_H
+#define IMAGEVIEW_H
+
+#include "ChannelPtr.h"
+#include "ImagePtr.h"
+
+namespace IP {
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView class declaration
+//! \brief	Rectangular region of an image, without a copy.
+//! \details	A view has its own origin, size and row stride, and
+//!		aliases the channels of its parent image: writing through
+//!		a view writes into the parent. Row y of a view channel
+//!		starts at row(ch, y), and consecutive rows are stride()
+//!		elements apart, so ChannelPtr kernels that take a stride
+//!		(e.g., IP_blur1DScratch) run on views directly. Views of
+//!		the same parent may overlap. A view holds a reference to
+//!		its parent; it stays valid until the parent is reallocated
+//!		with a new size.
+//
+class ImageView {
+public:
+	// constructors
+	ImageView();					// empty view
+	ImageView(const ImagePtr &);			// whole image
+	ImageView(const ImagePtr &, int, int, int, int);// region of image
+	ImageView(const ImageView &, int, int, int, int);// region of view
+
+	// get methods
+	bool	 isNull	    () const;		// empty view
+	int	 width	    () const;		// view width
+	int	 height	    () const;		// view height
+	int	 xoffset    () const;		// column of origin in parent
+	int	 yoffset    () const;		// row    of origin in parent
+	int	 stride	    () const;		// elements between rows
+	bool	 isContiguous() const;		// rows are adjacent in memory
+	int	 channelType(int) const;	// channel type
+	int	 maxChannel () const;		// number of channels
+	const ImagePtr &image() const;		// parent image
+
+	// channel access
+	template<class T>
+	ChannelPtr<T> channel(int) const;	// pixel (0,0) of channel
+	template<class T>
+	ChannelPtr<T> row    (int, int) const;	// pixel (0,y) of channel
+	template<class T>
+	bool	 getChannel (int, ChannelPtr<T>&, int &) const;
+
+private:
+	ImagePtr m_image;			// parent image
+	int	 m_x, m_y;			// origin in parent
+	int	 m_width, m_height;		// view dimensions
+	int	 m_stride;			// parent width
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::ImageView:
+//
+// Default constructor.
+//! \brief	Default constructor.
+//! \details	Empty view of an empty image.
+//
+inline
+ImageView::ImageView()
+	: m_x	  (0),
+	  m_y	  (0),
+	  m_width (0),
+	  m_height(0),
+	  m_stride(0)
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::ImageView:
+//
+// Constructor (whole image).
+//! \brief	View of all of image \a I.
+//! \param[in]	I - Parent image.
+//
+inline
+ImageView::ImageView(const ImagePtr &I)
+	: m_image (I),
+	  m_x	  (0),
+	  m_y	  (0),
+	  m_width (I->width ()),
+	  m_height(I->height()),
+	  m_stride(I->width ())
+{}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::ImageView:
+//
+// Constructor (region of image). The w x h region at (x,y) is clipped
+// to the bounds of I; a region outside I gives an empty view.
+//! \brief	View of the \a w x \a h region of \a I at (\a x,\a y).
+//! \param[in]	I   - Parent image.
+//! \param[in]	x,y - Origin of region in I.
+//! \param[in]	w,h - Region width and height.
+//
+inline
+ImageView::ImageView(const ImagePtr &I, int x, int y, int w, int h)
+	: m_image (I),
+	  m_stride(I->width())
+{
+	int x1 = CLIP(x+w, 0, I->width ());
+	int y1 = CLIP(y+h, 0, I->height());
+	m_x	 = CLIP(x, 0, x1);
+	m_y	 = CLIP(y, 0, y1);
+	m_width  = x1 - m_x;
+	m_height = y1 - m_y;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::ImageView:
+//
+// Constructor (region of view). Coordinates are relative to V and the
+// region is clipped to V. The result is a view of the parent of V.
+//! \brief	View of the \a w x \a h region of \a V at (\a x,\a y).
+//! \param[in]	V   - View.
+//! \param[in]	x,y - Origin of region in V.
+//! \param[in]	w,h - Region width and height.
+//
+inline
+ImageView::ImageView(const ImageView &V, int x, int y, int w, int h)
+	: m_image (V.m_image),
+	  m_stride(V.m_stride)
+{
+	int x1 = CLIP(x+w, 0, V.m_width );
+	int y1 = CLIP(y+h, 0, V.m_height);
+	x	 = CLIP(x, 0, x1);
+	y	 = CLIP(y, 0, y1);
+	m_x	 = V.m_x + x;
+	m_y	 = V.m_y + y;
+	m_width  = x1 - x;
+	m_height = y1 - y;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::isNull:
+//
+// Test if the view is empty.
+//! \brief	Test if the view is empty.
+//! \return	A boolean value.
+//
+inline bool
+ImageView::isNull() const
+{
+	return (m_width <= 0 || m_height <= 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::width:
+//
+// View width.
+//! \brief	View width.
+//
+inline int
+ImageView::width() const
+{
+	return m_width;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::height:
+//
+// View height.
+//! \brief	View height.
+//
+inline int
+ImageView::height() const
+{
+	return m_height;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::xoffset:
+//
+// Column of view origin in parent image.
+//! \brief	Column of view origin in parent image.
+//
+inline int
+ImageView::xoffset() const
+{
+	return m_x;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::yoffset:
+//
+// Row of view origin in parent image.
+//! \brief	Row of view origin in parent image.
+//
+inline int
+ImageView::yoffset() const
+{
+	return m_y;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::stride:
+//
+// Number of elements between vertically adjacent pixels.
+//! \brief	Row stride (elements).
+//
+inline int
+ImageView::stride() const
+{
+	return m_stride;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::isContiguous:
+//
+// Return true if the rows of the view follow each other in memory, so
+// that each channel may be processed as one buffer of width*height.
+//! \brief	Test if view rows are adjacent in memory.
+//! \return	A boolean value.
+//
+inline bool
+ImageView::isContiguous() const
+{
+	return (m_width == m_stride || m_height <= 1);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::channelType:
+//
+// Channel type of parent image.
+//! \brief	Channel type.
+//! \param[in]	ch - Channel index.
+//
+inline int
+ImageView::channelType(int ch) const
+{
+	return m_image->channelType(ch);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::maxChannel:
+//
+// Number of channels of parent image.
+//! \brief	Number of channels.
+//
+inline int
+ImageView::maxChannel() const
+{
+	return m_image->maxChannel();
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::image:
+//
+// Parent image.
+//! \brief	Parent image.
+//
+inline const ImagePtr &
+ImageView::image() const
+{
+	return m_image;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::channel:
+//
+// Pointer to pixel (0,0) of channel ch. The channel must be of type T.
+//! \brief	Pointer to the view origin in channel \a ch.
+//! \param[in]	ch - Channel index.
+//! \return	Channel pointer; rows are stride() elements apart.
+//
+template<class T>
+inline ChannelPtr<T>
+ImageView::channel(int ch) const
+{
+	return row<T>(ch, 0);
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::row:
+//
+// Pointer to pixel (0,y) of channel ch. The channel must be of type T.
+//! \brief	Pointer to row \a y of the view in channel \a ch.
+//! \param[in]	ch - Channel index.
+//! \param[in]	y  - Row index in view.
+//! \return	Channel pointer to width() elements.
+//
+template<class T>
+inline ChannelPtr<T>
+ImageView::row(int ch, int y) const
+{
+	ChannelPtr<T> p = (*m_image)[ch];
+	p += (m_y + y) * m_stride + m_x;
+	return p;
+}
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ImageView::getChannel:
+//
+// View counterpart of IP_getChannel(): pass pointer to view origin and
+// type of channel ch through args ptr and type.
+// Return true for success, false for failure.
+//! \brief	Pass origin and type of channel \a ch through \a ptr and
+//!		\a type.
+//! \param[in]	ch	- Channel index.
+//! \param[out]	ptr	- Pointer to pixel (0,0) of channel.
+//! \param[out]	type	- Channel datatype.
+//! \return	true for success, false for failure.
+//
+template<class T>
+inline bool
+ImageView::getChannel(int ch, ChannelPtr<T> &ptr, int &type) const
+{
+	if(ch < 0 || ch >= maxChannel()) return false;
+
+	ptr  = channel<T>(ch);
+	type = channelType(ch);
+	return true;
+}
+
+}	// namespace IP
+
+#endif	// IMAGEVIEW_H